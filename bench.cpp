@@ -0,0 +1,250 @@
+#include <serialize.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <random>
+#include <sstream>
+
+namespace {
+std::atomic<std::size_t> allocation_count{0};
+std::atomic<std::size_t> allocation_bytes{0};
+}
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) { return p; }
+    throw std::bad_alloc{};
+}
+
+// std::pmr::new_delete_resource() allocates through the aligned overloads.
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align)) { return p; }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+struct wide_flat {
+    int i0; int i1; int i2; int i3;
+    double d0; double d1; double d2; double d3;
+    bool b0; bool b1; bool b2; bool b3;
+    long long l0; long long l1; float f0; float f1;
+};
+
+struct level4 { int value; std::array<int, 2> pair; };
+struct level3 { level4 inner; bool flag; };
+struct level2 { level3 inner; double weight; };
+struct level1 { level2 inner; std::array<level3, 2> siblings; };
+struct deep_nested { level1 root; int id; };
+
+struct number_heavy {
+    std::array<double, 32> samples;
+    std::array<long long, 16> counters;
+};
+
+struct string_heavy {
+    std::string title;
+    std::string body;
+    std::string author;
+    int id;
+};
+
+struct sparse_optional {
+    int id;
+    std::optional<int> a; std::optional<double> b; std::optional<bool> c;
+    std::optional<int> d; std::optional<double> e; std::optional<bool> f;
+    std::optional<int> g; std::optional<double> h;
+};
+
+struct phase_result {
+    std::string corpus;
+    std::string phase;
+    std::size_t records;
+    std::size_t bytes;
+    double mb_per_s;
+    double ns_per_record;
+    double allocations_per_record;
+    double allocated_bytes_per_record;
+};
+
+std::mt19937_64 rng{20240601};
+
+int random_int(int lo, int hi) { return std::uniform_int_distribution<int>{lo, hi}(rng); }
+double random_double() { return std::uniform_real_distribution<double>{-1e6, 1e6}(rng); }
+
+std::string random_text(std::size_t length) {
+    static constexpr char alphabet[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789.,";
+    std::string text(length, ' ');
+    for (auto& c : text) {
+        int roll = random_int(0, 99);
+        if (roll == 0) { c = '"'; }
+        else if (roll == 1) { c = '\\'; }
+        else if (roll == 2) { c = '\n'; }
+        else { c = alphabet[random_int(0, sizeof(alphabet) - 2)]; }
+    }
+    return text;
+}
+
+wide_flat make_wide_flat() {
+    return {random_int(-1000, 1000), random_int(0, 9), random_int(-1 << 30, 1 << 30), random_int(0, 99),
+            random_double(), random_double(), random_double() / 1e9, random_double(),
+            random_int(0, 1) == 1, random_int(0, 1) == 1, random_int(0, 1) == 1, random_int(0, 1) == 1,
+            random_int(-1 << 30, 1 << 30) * 1000ll, random_int(0, 1000), static_cast<float>(random_double()), 0.5f};
+}
+
+deep_nested make_deep_nested() {
+    auto l4 = [] { return level4{random_int(0, 1000), {random_int(0, 9), random_int(0, 9)}}; };
+    auto l3 = [&] { return level3{l4(), random_int(0, 1) == 1}; };
+    return {{{l3(), random_double()}, {l3(), l3()}}, random_int(0, 1 << 20)};
+}
+
+number_heavy make_number_heavy() {
+    number_heavy record{};
+    for (auto& sample : record.samples) { sample = random_double(); }
+    for (auto& counter : record.counters) { counter = random_int(0, 1 << 30) * 4096ll; }
+    return record;
+}
+
+string_heavy make_string_heavy() {
+    return {random_text(40), random_text(400), random_text(16), random_int(0, 1 << 20)};
+}
+
+sparse_optional make_sparse_optional() {
+    sparse_optional record{};
+    record.id = random_int(0, 1 << 20);
+    if (random_int(0, 7) == 0) { record.a = random_int(0, 100); }
+    if (random_int(0, 7) == 0) { record.b = random_double(); }
+    if (random_int(0, 7) == 0) { record.f = true; }
+    if (random_int(0, 7) == 0) { record.h = random_double(); }
+    return record;
+}
+
+// Runs `fn` (one pass over the corpus) until at least min_seconds have
+// elapsed and reports throughput and allocations per pass.
+template <typename Fn>
+phase_result measure(const std::string& corpus, const std::string& phase,
+                     std::size_t records, std::size_t bytes, Fn&& fn) {
+    constexpr double min_seconds = 0.2;
+    fn();  // warm-up
+    std::size_t passes = 0;
+    std::size_t count_before = allocation_count.load();
+    std::size_t bytes_before = allocation_bytes.load();
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    do {
+        fn();
+        ++passes;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < min_seconds);
+    double total_records = static_cast<double>(records * passes);
+    return {corpus, phase, records, bytes,
+            static_cast<double>(bytes * passes) / (1024.0 * 1024.0) / elapsed.count(),
+            elapsed.count() * 1e9 / total_records,
+            static_cast<double>(allocation_count.load() - count_before) / total_records,
+            static_cast<double>(allocation_bytes.load() - bytes_before) / total_records};
+}
+
+template <typename T, typename Make>
+void run_corpus(const std::string& name, std::size_t records, Make&& make, std::vector<phase_result>& results) {
+    std::vector<T> corpus;
+    corpus.reserve(records);
+    for (std::size_t i = 0; i < records; ++i) { corpus.push_back(make()); }
+
+    std::vector<std::string> texts;
+    std::size_t record_bytes = 0;
+    for (auto& record : corpus) {
+        texts.push_back(serializez::serialize(record));
+        record_bytes += texts.back().size();
+    }
+    std::string document = serializez::serialize_parallel(std::span<const T>{corpus}, 1);
+
+    serializez::buffer out;
+    results.push_back(measure(name, "serialize", records, record_bytes, [&] {
+        for (auto& record : corpus) {
+            out.clear();
+            serializez::serialize_into(record, out);
+        }
+    }));
+
+    results.push_back(measure(name, "serialize_stringstream", records, record_bytes, [&] {
+        for (auto& record : corpus) {
+            std::stringstream stream;
+            serializez::serialize_into(record, stream);
+            (void)stream.str();
+        }
+    }));
+
+    std::pmr::vector<std::uint32_t> index;
+    results.push_back(measure(name, "tokenize", records, document.size(), [&] {
+        serializez::detail::Tokenizer tokenizer(document, std::move(index));
+        for (tokenizer.next(); tokenizer.token != serializez::detail::Token::END; tokenizer.skip_to_next()) { }
+        index = tokenizer.release_index();
+    }));
+
+    serializez::Document doc;
+    results.push_back(measure(name, "parse_json", records, document.size(), [&] {
+        if (serializez::parse(document, doc)) { std::abort(); }
+    }));
+
+    results.push_back(measure(name, "validate", records, document.size(), [&] {
+        if (serializez::validate(document).error) { std::abort(); }
+    }));
+
+    T target{};
+    results.push_back(measure(name, "deserialize", records, record_bytes, [&] {
+        for (auto& text : texts) {
+            if (serializez::deserialize(target, std::string_view{text})) { std::abort(); }
+        }
+    }));
+
+    std::vector<std::string> messages;
+    std::size_t message_bytes = 0;
+    for (auto& record : corpus) {
+        messages.push_back(serializez::serialize_binary(record));
+        message_bytes += messages.back().size();
+    }
+    results.push_back(measure(name, "serialize_binary", records, message_bytes, [&] {
+        for (auto& record : corpus) {
+            out.clear();
+            serializez::serialize_binary_into(record, out);
+        }
+    }));
+
+    results.push_back(measure(name, "deserialize_binary", records, message_bytes, [&] {
+        for (auto& message : messages) {
+            if (serializez::deserialize_binary(target, std::string_view{message})) { std::abort(); }
+        }
+    }));
+}
+
+int main(int argc, char** argv) {
+    const char* output = argc > 1 ? argv[1] : "serialize_bench.json";
+    std::vector<phase_result> results;
+    run_corpus<wide_flat>("wide_flat", 20000, make_wide_flat, results);
+    run_corpus<deep_nested>("deep_nested", 20000, make_deep_nested, results);
+    run_corpus<number_heavy>("number_heavy", 5000, make_number_heavy, results);
+    run_corpus<string_heavy>("string_heavy", 5000, make_string_heavy, results);
+    run_corpus<sparse_optional>("sparse_optional", 20000, make_sparse_optional, results);
+
+    std::printf("%-16s %-24s %10s %12s %10s %12s\n",
+                "corpus", "phase", "MB/s", "ns/record", "allocs/rec", "alloc B/rec");
+    for (auto& r : results) {
+        std::printf("%-16s %-24s %10.1f %12.1f %10.2f %12.1f\n", r.corpus.c_str(), r.phase.c_str(),
+                    r.mb_per_s, r.ns_per_record, r.allocations_per_record, r.allocated_bytes_per_record);
+    }
+
+    std::ofstream file(output);
+    file << serializez::serialize(results) << '\n';
+    std::printf("results written to %s\n", output);
+}
@@ -46,18 +46,16 @@ int main() {
     } else {
         std::cout << "Success!" << std::endl;
     }
-    auto* tokenizer = new serializez::detail::Tokenizer(json);
-    tokenizer->next();
 
 #ifdef DEBUG
-    using namespace serializez::detail;
-    auto parse_result = parse_json(tokenizer);
-    if (!parse_result) {
-        std::cout << "Parse result is nullptr";
+    serializez::Document doc;
+    if (serializez::parse(json, doc)) {
+        std::cout << "Parse failed";
     } else {
-        std::cout << "Top level node is " << parse_result->class_name() << std::endl;
-        std::cout << "a is node " << As<Members>(parse_result)->get("a")->class_name() << std::endl;
-        std::cout << "opt1 is node " << As<Members>(parse_result)->get("opt1")->class_name() << std::endl;
+        auto parse_result = doc.root();
+        std::cout << "Top level node is " << parse_result.class_name() << std::endl;
+        std::cout << "a is node " << parse_result["a"].class_name() << std::endl;
+        std::cout << "opt1 is node " << parse_result["opt1"].class_name() << std::endl;
     }
 #endif
 } 
@@ -1,16 +1,41 @@
 #include <reflect>
 #include <concepts>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <cstring>
+#include <charconv>
+#include <cmath>
+#include <limits>
 #include <type_traits>
 #include <ranges>
 #include <optional>
 #include <utility>
 #include <span>
+#include <array>
 #include <memory>
+#include <memory_resource>
 #include <vector>
-#include <list>
-#include <map>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <chrono>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <istream>
+#include <cerrno>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #ifdef DEBUG
 #include <iostream>
@@ -30,6 +55,19 @@ namespace {
                                   std::ranges::sized_range<T>
                                   && (not any_string<T>);
     
+    template <typename T>
+    concept resizable_range = sized_forward_range<T> && requires(T& range, std::size_t n) {
+        range.resize(n);
+        range.emplace_back();
+    };
+
+    template <typename T>
+    concept string_keyed_map = sized_forward_range<T> && any_string<typename T::key_type>
+                               && requires(T& map, const typename T::key_type& key) {
+        typename T::mapped_type;
+        map.try_emplace(key);
+    };
+
     template <typename T>
     concept numeric = std::integral<T> || std::floating_point<T>;
     
@@ -39,8 +77,248 @@ namespace {
 
 
 namespace serializez {
+
+class buffer {
+public:
+    explicit buffer(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : resource(resource) { }
+    explicit buffer(std::size_t initial_capacity,
+                    std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : resource(resource) { reserve(initial_capacity); }
+
+    buffer(const buffer&) = delete;
+    buffer& operator=(const buffer&) = delete;
+    buffer(buffer&& other) noexcept
+        : resource(other.resource), storage(std::exchange(other.storage, nullptr)),
+          length(std::exchange(other.length, 0)), cap(std::exchange(other.cap, 0)) { }
+    buffer& operator=(buffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            resource = other.resource;
+            storage = std::exchange(other.storage, nullptr);
+            length = std::exchange(other.length, 0);
+            cap = std::exchange(other.cap, 0);
+        }
+        return *this;
+    }
+    ~buffer() { release(); }
+
+    inline void put(char c) {
+        if (length == cap) [[unlikely]] { grow(1); }
+        storage[length++] = c;
+    }
+
+    inline void write(const char* src, std::size_t n) {
+        if (cap - length < n) [[unlikely]] { grow(n); }
+        std::memcpy(storage + length, src, n);
+        length += n;
+    }
+
+    inline void reserve(std::size_t new_capacity) {
+        if (new_capacity <= cap) { return; }
+        char* grown = static_cast<char*>(resource->allocate(new_capacity, 1));
+        if (length) { std::memcpy(grown, storage, length); }
+        release();
+        storage = grown;
+        cap = new_capacity;
+    }
+
+    // Makes room for `n` more bytes and returns where they start; commit()
+    // then adds the bytes actually written to the size.
+    inline char* prepare(std::size_t n) {
+        if (cap - length < n) { grow(n); }
+        return storage + length;
+    }
+
+    inline void commit(std::size_t n) { length += n; }
+
+    inline void clear() { length = 0; }
+    inline const char* data() const { return storage; }
+    inline std::size_t size() const { return length; }
+    inline std::size_t capacity() const { return cap; }
+    inline std::string_view view() const { return {storage, length}; }
+    inline std::string str() const { return std::string{view()}; }
+
+private:
+    std::pmr::memory_resource* resource;
+    char* storage = nullptr;
+    std::size_t length = 0ul;
+    std::size_t cap = 0ul;
+
+    void grow(std::size_t n) {
+        reserve(std::max({cap * 2, length + n, std::size_t{64}}));
+    }
+
+    void release() {
+        if (storage) { resource->deallocate(storage, cap, 1); }
+        storage = nullptr;
+    }
+};
+
+// Counters filled in by the calls that receive an options object with a
+// stats sink. Calls add to the counters, so one sink can aggregate many
+// calls; max_depth keeps the deepest document seen.
+struct stats {
+    std::size_t bytes_read = 0ul;
+    std::size_t bytes_written = 0ul;
+    std::size_t tokens = 0ul;       // structural index entries
+    std::size_t nodes = 0ul;        // values in the document, keys excluded
+    std::size_t max_depth = 0ul;
+    std::size_t allocations = 0ul;  // made through the options' memory resource
+    std::size_t allocated_bytes = 0ul;
+    std::chrono::nanoseconds tokenize_time{};
+    std::chrono::nanoseconds build_time{};  // serializing, or building the tape
+    std::chrono::nanoseconds bind_time{};   // filling a typed value from tokens
+};
+
+// Deepest nesting of objects and arrays accepted by default; deeper input
+// is error 7.
+inline constexpr std::size_t default_max_depth = 1024ul;
+
+// Largest JSON input the token index can address (offsets are 32-bit);
+// larger input is error 8.
+inline constexpr std::size_t max_input_size = std::numeric_limits<std::uint32_t>::max();
+
+// Per-call settings. Internal allocations (index, tape and output scratch)
+// come from `resource`; when `sink` is null no counting or timing is done.
+struct options {
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+    stats* sink = nullptr;
+    // deserialize() points unescaped std::string_view fields into the input
+    // and decodes escaped ones into this arena; without one they are error 1.
+    std::pmr::memory_resource* string_arena = nullptr;
+    // Deepest nesting parse() and deserialize() accept.
+    std::size_t max_depth = default_max_depth;
+};
+
+// A JSON value kept as its text. deserialize() captures the bytes of the
+// value by matching brackets, without reading what is inside, and views the
+// input like std::string_view fields do; serialize() writes them back
+// verbatim. Only the brackets are checked, so a captured value can hold
+// invalid JSON such as [1,,2]; validate() it before forwarding untrusted
+// input. A default-constructed raw_json is written as null. Bound from
+// a parsed Document, it views the input the Document was parsed from.
+class raw_json {
+public:
+    raw_json() = default;
+    explicit raw_json(std::string_view json) : text(json) { }
+
+    std::string_view json() const { return text; }
+    bool empty() const { return text.empty(); }
+
+    // Deserializes the captured text into `out`; the deserialize() error codes.
+    template <typename T>
+    int parse_as(T& out) const;
+
+    // As above, returning a value-initialized T on error.
+    template <typename T>
+    T parse_as() const {
+        T out{};
+        return parse_as(out) == 0 ? out : T{};
+    }
+
+    friend bool operator==(const raw_json&, const raw_json&) = default;
+
+private:
+    std::string_view text;
+};
+
+namespace detail {
+
+// Forwards to `upstream`, counting what is allocated through it.
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream) : upstream(upstream) { }
+
+    std::size_t allocations = 0ul;
+    std::size_t allocated_bytes = 0ul;
+
+private:
+    std::pmr::memory_resource* upstream;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocations;
+        allocated_bytes += bytes;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Adds the time since the previous lap to a phase of `sink`; without a sink
+// it never reads the clock.
+class Stopwatch {
+public:
+    explicit Stopwatch(stats* sink) : sink(sink) {
+        if (sink) { start = std::chrono::steady_clock::now(); }
+    }
+
+    void lap(std::chrono::nanoseconds stats::* phase) {
+        if (!sink) { return; }
+        auto now = std::chrono::steady_clock::now();
+        sink->*phase += std::chrono::duration_cast<std::chrono::nanoseconds>(now - start);
+        start = now;
+    }
+
+private:
+    stats* sink;
+    std::chrono::steady_clock::time_point start{};
+};
+
+inline void record_allocations(stats& sink, const CountingResource& counter) {
+    sink.allocations += counter.allocations;
+    sink.allocated_bytes += counter.allocated_bytes;
+}
+} // namespace detail
+
 namespace detail {
 
+template <std::size_t I, typename T>
+constexpr void write_key_fragment(char* out) {
+    constexpr std::string_view name = reflect::member_name<I, T>();
+    *out++ = I == 0 ? '{' : ',';
+    *out++ = '\"';
+    for (char c : name) { *out++ = c; }
+    *out++ = '\"';
+    *out++ = ':';
+}
+
+// Concatenated `{"name":` / `,"name":` fragments of an aggregate, one per member.
+// Member names are identifiers, so they never need escaping.
+template <typename T>
+struct member_keys {
+    static constexpr std::size_t count = reflect::size<T>();
+
+    static constexpr auto offsets = [] {
+        std::array<std::size_t, count + 1> result{};
+        std::size_t pos = 0ul;
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ((result[I] = pos, pos += reflect::member_name<I, T>().size() + 4), ...);
+        }(std::make_index_sequence<count>{});
+        result[count] = pos;
+        return result;
+    }();
+
+    static constexpr auto fragments = [] {
+        std::array<char, offsets[count]> result{};
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            (write_key_fragment<I, T>(result.data() + offsets[I]), ...);
+        }(std::make_index_sequence<count>{});
+        return result;
+    }();
+
+    template <std::size_t I>
+    static constexpr std::string_view key() {
+        return {fragments.data() + offsets[I], offsets[I + 1] - offsets[I]};
+    }
+};
+
 template <typename T>
 struct serializer_impl {
     template <typename U, std::size_t N, typename Stream>
@@ -51,21 +329,19 @@ struct serializer_impl {
 
     template <typename U, typename Stream>
     static void serialize(U&& obj, Stream& stream) {
-        stream << '{';
-        auto pos_before = stream.tellp();
-        reflect::for_each([&](auto I){
-            auto member_name = reflect::member_name<I, T>();
-            auto& ith_member = reflect::get<I>(obj);
-            using member_t = std::remove_cvref_t<decltype(ith_member)>;
+        if constexpr (member_keys<T>::count == 0) {
+            stream.write("{}", 2);
+        } else {
+            reflect::for_each([&](auto I){
+                constexpr std::string_view key = member_keys<T>::template key<I>();
+                auto& ith_member = reflect::get<I>(obj);
+                using member_t = std::remove_cvref_t<decltype(ith_member)>;
 
-            stream << '\"' << member_name << '\"' << ':';
-            serializer_impl<member_t>::serialize(ith_member, stream);
-            stream << ',';
-        }, obj);
-        if (stream.tellp() != pos_before) {
-            stream.seekp(-1, std::ios_base::end); 
+                stream.write(key.data(), key.size());
+                serializer_impl<member_t>::serialize(ith_member, stream);
+            }, obj);
+            stream.put('}');
         }
-        stream << '}';
     }
 };
 
@@ -73,41 +349,154 @@ template <sized_forward_range T>
 struct serializer_impl<T> {
     template <typename U, typename Stream>
     static void serialize(U&& range, Stream& stream) {
-        stream << '[';
-        auto pos_before = stream.tellp();
-        for (auto it = std::ranges::begin(range); it != std::ranges::end(range); ++it) {
-            using value_t = std::remove_cvref_t<decltype(*it)>;
+        stream.put('[');
+        auto it = std::ranges::begin(range);
+        auto end = std::ranges::end(range);
+        using value_t = std::remove_cvref_t<decltype(*it)>;
+        if (it != end) {
             serializer_impl<value_t>::serialize(*it, stream);
-            stream << ',';
+            for (++it; it != end; ++it) {
+                stream.put(',');
+                serializer_impl<value_t>::serialize(*it, stream);
+            }
         }
-        if (stream.tellp() != pos_before) {
-            stream.seekp(-1, std::ios_base::end); 
+        stream.put(']');
+    }
+};
+
+template <string_keyed_map T>
+struct serializer_impl<T> {
+    template <typename U, typename Stream>
+    static void serialize(U&& map, Stream& stream) {
+        using key_t = typename T::key_type;
+        using mapped_t = typename T::mapped_type;
+        char separator = '{';
+        for (auto& [key, value] : map) {
+            stream.put(separator);
+            serializer_impl<key_t>::serialize(key, stream);
+            stream.put(':');
+            serializer_impl<mapped_t>::serialize(value, stream);
+            separator = ',';
         }
-        stream << ']';
+        if (separator == '{') { stream.put('{'); }
+        stream.put('}');
     }
 };
 
+inline bool needs_escape(char c) {
+    return static_cast<unsigned char>(c) < 0x20 || c == '\"' || c == '\\';
+}
+
+// Offset of the first byte in data[0, size) that must be escaped, or size.
+inline std::size_t find_escape(const char* data, std::size_t size) {
+    std::size_t i = 0ul;
+#if defined(__AVX2__)
+    const __m256i quote32 = _mm256_set1_epi8('\"');
+    const __m256i backslash32 = _mm256_set1_epi8('\\');
+    const __m256i control32 = _mm256_set1_epi8(0x1f);
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote32), _mm256_cmpeq_epi8(chunk, backslash32)),
+            _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control32), control32));
+        auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(special));
+        if (mask) { return i + std::countr_zero(mask); }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i quote16 = _mm_set1_epi8('\"');
+    const __m128i backslash16 = _mm_set1_epi8('\\');
+    const __m128i control16 = _mm_set1_epi8(0x1f);
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote16), _mm_cmpeq_epi8(chunk, backslash16)),
+            _mm_cmpeq_epi8(_mm_max_epu8(chunk, control16), control16));
+        auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(special));
+        if (mask) { return i + std::countr_zero(mask); }
+    }
+#endif
+    for (; i < size; ++i) {
+        if (needs_escape(data[i])) { return i; }
+    }
+    return size;
+}
+
+template <typename Stream>
+void write_escape_sequence(char c, Stream& stream) {
+    switch (c) {
+        case '\"': stream.write("\\\"", 2); return;
+        case '\\': stream.write("\\\\", 2); return;
+        case '\b': stream.write("\\b", 2); return;
+        case '\f': stream.write("\\f", 2); return;
+        case '\n': stream.write("\\n", 2); return;
+        case '\r': stream.write("\\r", 2); return;
+        case '\t': stream.write("\\t", 2); return;
+    }
+    constexpr char hex[] = "0123456789abcdef";
+    auto byte = static_cast<unsigned char>(c);
+    char unicode[] = {'\\', 'u', '0', '0', hex[byte >> 4], hex[byte & 0xf]};
+    stream.write(unicode, sizeof(unicode));
+}
+
+template <typename Stream>
+void write_escaped(std::string_view str, Stream& stream) {
+    const char* data = str.data();
+    std::size_t size = str.size();
+    stream.put('\"');
+    while (true) {
+        std::size_t clean = find_escape(data, size);
+        stream.write(data, clean);
+        if (clean == size) { break; }
+        write_escape_sequence(data[clean], stream);
+        data += clean + 1;
+        size -= clean + 1;
+    }
+    stream.put('\"');
+}
+
 template <any_string T>
 struct serializer_impl<T> {
     template <typename U, typename Stream>
     static void serialize(U&& str, Stream& stream) {
-        std::string data{std::forward<U>(str)};
-        stream <<  '\"';
-        for (auto c : data) {
-            if (c == '\"') {
-                stream << '\\';
-            }
-            stream << c;
+        if constexpr (std::is_convertible_v<U, std::string_view>) {
+            write_escaped(std::string_view{str}, stream);
+        } else {
+            write_escaped(std::string{std::forward<U>(str)}, stream);
         }
-        stream << '\"';
     }
 };
 
+inline constexpr char two_digits[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
 template <numeric_except_bool T>
 struct serializer_impl<T> {
     template <typename U, typename Stream>
     static void serialize(U&& obj, Stream& stream) {
-       stream << std::to_string(obj); 
+        if constexpr (std::is_integral_v<T>) {
+            auto magnitude = static_cast<std::make_unsigned_t<T>>(obj);
+            if (magnitude < 10u) {
+                stream.put(static_cast<char>('0' + magnitude));
+                return;
+            }
+            if (magnitude < 100u) {
+                stream.write(two_digits + 2 * magnitude, 2);
+                return;
+            }
+        } else {
+            if (!std::isfinite(obj)) {
+                stream.write("null", 4);
+                return;
+            }
+        }
+        // Shortest representation that reads back to the same T; for float and
+        // double to_chars picks the digits of the respective type.
+        char digits[32];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), obj);
+        stream.write(digits, static_cast<std::size_t>(end - digits));
     }
 };
 
@@ -115,7 +504,23 @@ template<>
 struct serializer_impl<bool> {
     template <typename Stream>
     static void serialize(bool obj, Stream& stream) {
-        stream << (obj ? "true" : "false");
+        if (obj) {
+            stream.write("true", 4);
+        } else {
+            stream.write("false", 5);
+        }
+    }
+};
+
+template <>
+struct serializer_impl<raw_json> {
+    template <typename Stream>
+    static void serialize(const raw_json& obj, Stream& stream) {
+        if (obj.empty()) {
+            stream.write("null", 4);
+        } else {
+            stream.write(obj.json().data(), obj.json().size());
+        }
     }
 };
 
@@ -124,19 +529,167 @@ struct serializer_impl<std::optional<T>> {
     template <typename U, typename Stream>
     static void serialize(U&& obj, Stream& stream) {
         if (obj.has_value()) {
-            serializer_impl<T>::serialize(std::forward<T>(*obj), stream);
+            serializer_impl<T>::serialize(*obj, stream);
+        } else {
+            stream.write("null", 4);
+        }
+    }
+};
+} // namespace detail
+
+// Returned by max_serialized_size() for types whose JSON has no size bound.
+inline constexpr std::size_t unbounded_size = std::numeric_limits<std::size_t>::max();
+
+namespace detail {
+
+template <typename T>
+struct is_optional : std::false_type {};
+
+template <typename T>
+struct is_optional<std::optional<T>> : std::true_type {};
+
+template <typename T>
+struct is_std_array : std::false_type {};
+
+template <typename T, std::size_t N>
+struct is_std_array<std::array<T, N>> : std::true_type {};
+
+template <typename T>
+struct is_std_span : std::false_type {};
+
+template <typename T, std::size_t N>
+struct is_std_span<std::span<T, N>> : std::true_type {};
+
+// Number of elements of a range type whose size is part of the type
+// (std::array, C arrays, fixed-extent std::span), or std::dynamic_extent.
+// Other tuple-like ranges such as std::ranges::subrange are not fixed-size.
+template <typename T>
+constexpr std::size_t static_extent() {
+    if constexpr (std::is_bounded_array_v<T>) {
+        return std::extent_v<T>;
+    } else if constexpr (is_std_array<T>::value) {
+        return std::tuple_size_v<T>;
+    } else if constexpr (is_std_span<T>::value) {
+        return T::extent;
+    } else {
+        return std::dynamic_extent;
+    }
+}
+
+constexpr std::size_t bounded_add(std::size_t a, std::size_t b) {
+    return a == unbounded_size || b == unbounded_size || b > unbounded_size - 1 - a ? unbounded_size : a + b;
+}
+
+constexpr std::size_t bounded_mul(std::size_t a, std::size_t n) {
+    return a == unbounded_size || (n && a > (unbounded_size - 1) / n) ? unbounded_size : a * n;
+}
+
+template <typename T>
+constexpr std::size_t max_size() {
+    if constexpr (std::same_as<T, bool>) {
+        return 5;  // false
+    } else if constexpr (std::floating_point<T>) {
+        // -d.ddde-xxx with max_digits10 significant digits; NaN and Inf are null
+        std::size_t exponent_digits = 1;
+        for (int e = std::numeric_limits<T>::max_exponent10; e >= 10; e /= 10) { ++exponent_digits; }
+        return 1 + std::numeric_limits<T>::max_digits10 + 1 + 2 + exponent_digits;
+    } else if constexpr (numeric_except_bool<T>) {
+        return std::numeric_limits<T>::digits10 + 1 + std::is_signed_v<T>;
+    } else if constexpr (is_optional<T>::value) {
+        return std::max(std::size_t{4}, max_size<typename T::value_type>());
+    } else if constexpr (any_string<T> || std::same_as<T, raw_json>) {
+        return unbounded_size;
+    } else if constexpr (sized_forward_range<T>) {
+        constexpr std::size_t n = static_extent<T>();
+        if constexpr (n == std::dynamic_extent) {
+            return unbounded_size;
         } else {
-            stream << "null";
+            using value_t = std::remove_cv_t<std::ranges::range_value_t<T>>;
+            std::size_t elements = bounded_mul(max_size<value_t>(), n);
+            return bounded_add(elements, n ? n + 1 : 2);  // brackets and commas
         }
+    } else if constexpr (member_keys<T>::count == 0) {
+        return 2;
+    } else {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            std::size_t total = member_keys<T>::offsets[member_keys<T>::count] + 1;
+            ((total = bounded_add(total, max_size<std::remove_cvref_t<decltype(reflect::get<I>(std::declval<T&>()))>>())), ...);
+            return total;
+        }(std::make_index_sequence<member_keys<T>::count>{});
+    }
+}
+
+// Sink over memory already known to be large enough for the whole output.
+struct UncheckedSink {
+    char* cursor;
+
+    inline void put(char c) { *cursor++ = c; }
+
+    inline void write(const char* src, std::size_t n) {
+        std::memcpy(cursor, src, n);
+        cursor += n;
     }
 };
+
+// Outputs up to this size go through a stack buffer in serialize_into().
+inline constexpr std::size_t stack_sink_limit = 4096ul;
 } // namespace detail
 
+// Worst-case length of the JSON for T, computed from its reflected members,
+// or unbounded_size if T contains strings or ranges without a fixed size.
+template <typename T>
+constexpr std::size_t max_serialized_size() {
+    return detail::max_size<std::remove_cvref_t<T>>();
+}
+
+// Types with a bounded size are written without per-write capacity checks:
+// straight into a buffer reserved for the worst case, or for other sinks
+// into a stack buffer that is flushed with a single write.
+template <typename T, typename Stream>
+void serialize_into(T&& obj, Stream& out) {
+    using type = std::remove_cvref_t<T>;
+    constexpr std::size_t bound = max_serialized_size<type>();
+    if constexpr (bound != unbounded_size && std::same_as<Stream, buffer>) {
+        char* start = out.prepare(bound);
+        detail::UncheckedSink sink{start};
+        detail::serializer_impl<type>::serialize(std::forward<T>(obj), sink);
+        out.commit(static_cast<std::size_t>(sink.cursor - start));
+    } else if constexpr (bound <= detail::stack_sink_limit) {
+        char stack[bound];
+        detail::UncheckedSink sink{stack};
+        detail::serializer_impl<type>::serialize(std::forward<T>(obj), sink);
+        out.write(stack, static_cast<std::size_t>(sink.cursor - stack));
+    } else {
+        detail::serializer_impl<type>::serialize(std::forward<T>(obj), out);
+    }
+}
+
 template <typename T>
 std::string serialize(T&& obj) {
-    std::stringstream stream;
-    detail::serializer_impl<T>::serialize(std::forward<T>(obj), stream);
-    return stream.str();
+    buffer out;
+    serialize_into(std::forward<T>(obj), out);
+    return out.str();
+}
+
+// As serialize_into(), recording the output size and time in `opts.sink`.
+// `out` allocates from its own resource.
+template <typename T>
+void serialize_into(T&& obj, buffer& out, const options& opts) {
+    std::size_t before = out.size();
+    detail::Stopwatch watch(opts.sink);
+    serialize_into(std::forward<T>(obj), out);
+    watch.lap(&stats::build_time);
+    if (opts.sink) { opts.sink->bytes_written += out.size() - before; }
+}
+
+// As serialize(), with the output scratch allocated from `opts.resource`.
+template <typename T>
+std::string serialize(T&& obj, const options& opts) {
+    detail::CountingResource counter(opts.resource);
+    buffer out(opts.sink ? &counter : opts.resource);
+    serialize_into(std::forward<T>(obj), out, opts);
+    if (opts.sink) { detail::record_allocations(*opts.sink, counter); }
+    return out.str();
 }
 
 namespace detail {
@@ -146,7 +699,6 @@ enum class Token {
     CURLY_CLOSE,
     SQUARE_OPEN,
     SQUARE_CLOSE,
-    QUOTE,
     COLON,
     COMMA,
     BOOL_TRUE,
@@ -154,37 +706,462 @@ enum class Token {
     NUMBER_FLOAT,
     NUMBER_INT,
     STRING,
-    NULL_TOKEN
+    NULL_TOKEN,
+    END,
+    INVALID
+};
+
+inline bool is_whitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool ends_literal(char c) {
+    switch (c) {
+        case ' ': case '\n': case '\r': case '\t':
+        case '{': case '}': case '[': case ']': case ':': case ',': case '"':
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Bit i of each mask describes byte i of a 64-byte block.
+struct block_masks {
+    std::uint64_t backslash;
+    std::uint64_t quote;
+    std::uint64_t whitespace;
+    std::uint64_t op;
 };
 
+inline block_masks classify_block(const char* block) {
+#if defined(__AVX2__)
+    auto classify = [](const char* p) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+        auto eq = [&](__m256i v, char c) { return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)); };
+        auto bits = [](__m256i v) { return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(v))); };
+        return block_masks{
+            bits(eq(chunk, '\\')),
+            bits(eq(chunk, '"')),
+            bits(_mm256_or_si256(_mm256_or_si256(eq(chunk, ' '), eq(chunk, '\n')),
+                                 _mm256_or_si256(eq(chunk, '\r'), eq(chunk, '\t')))),
+            bits(_mm256_or_si256(_mm256_or_si256(eq(folded, '{'), eq(folded, '}')),
+                                 _mm256_or_si256(eq(chunk, ':'), eq(chunk, ','))))
+        };
+    };
+    block_masks lo = classify(block), hi = classify(block + 32);
+    return {lo.backslash | hi.backslash << 32, lo.quote | hi.quote << 32,
+            lo.whitespace | hi.whitespace << 32, lo.op | hi.op << 32};
+#elif defined(__SSE2__)
+    block_masks masks{};
+    for (int part = 0; part < 4; ++part) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * part));
+        __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+        auto eq = [&](__m128i v, char c) { return _mm_cmpeq_epi8(v, _mm_set1_epi8(c)); };
+        auto bits = [&](__m128i v) {
+            return static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(v))) << (16 * part);
+        };
+        masks.backslash |= bits(eq(chunk, '\\'));
+        masks.quote |= bits(eq(chunk, '"'));
+        masks.whitespace |= bits(_mm_or_si128(_mm_or_si128(eq(chunk, ' '), eq(chunk, '\n')),
+                                              _mm_or_si128(eq(chunk, '\r'), eq(chunk, '\t'))));
+        masks.op |= bits(_mm_or_si128(_mm_or_si128(eq(folded, '{'), eq(folded, '}')),
+                                      _mm_or_si128(eq(chunk, ':'), eq(chunk, ','))));
+    }
+    return masks;
+#else
+    block_masks masks{};
+    for (int i = 0; i < 64; ++i) {
+        std::uint64_t bit = std::uint64_t{1} << i;
+        switch (block[i]) {
+            case '\\': masks.backslash |= bit; break;
+            case '"': masks.quote |= bit; break;
+            case ' ': case '\n': case '\r': case '\t': masks.whitespace |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': masks.op |= bit; break;
+        }
+    }
+    return masks;
+#endif
+}
+
+// Bit i set when bits [0, i] of x contain an odd number of ones.
+inline std::uint64_t prefix_xor(std::uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Characters preceded by an unescaped backslash. `carry` holds whether the
+// previous block ended with one.
+inline std::uint64_t find_escaped(std::uint64_t backslash, std::uint64_t& carry) {
+    std::uint64_t escaped = carry;
+    backslash &= ~carry;
+    carry = 0;
+    while (backslash) {
+        int i = std::countr_zero(backslash);
+        if (i == 63) {
+            carry = 1;
+            break;
+        }
+        escaped |= std::uint64_t{1} << (i + 1);
+        backslash &= ~(std::uint64_t{3} << i);
+    }
+    return escaped;
+}
+
+// Offsets of every structural character, every unescaped quote (opening and
+// closing) and the first byte of every literal or number, in input order.
+// Inputs are limited to 4 GiB; larger inputs produce an empty index.
+inline void index_structurals(std::string_view input, std::pmr::vector<std::uint32_t>& index) {
+    index.clear();
+    if (input.size() > max_input_size) { return; }
+    std::size_t count = 0ul;
+    std::uint64_t escape_carry = 0, in_string_carry = 0, scalar_carry = 0;
+    auto process = [&](const char* block, std::size_t base) {
+        block_masks masks = classify_block(block);
+        std::uint64_t quote = masks.quote & ~find_escaped(masks.backslash, escape_carry);
+        std::uint64_t in_string = prefix_xor(quote) ^ in_string_carry;
+        in_string_carry = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+        std::uint64_t scalar = ~(masks.op | masks.whitespace | quote);
+        std::uint64_t scalar_starts = scalar & ~(scalar << 1 | scalar_carry);
+        scalar_carry = scalar >> 63;
+        std::uint64_t structurals = ((masks.op | scalar_starts) & ~in_string) | quote;
+
+        if (index.size() < count + 64) {
+            index.resize(std::max(index.size() * 2, count + 64));
+        }
+        std::uint32_t* out = index.data() + count;
+        count += static_cast<std::size_t>(std::popcount(structurals));
+        for (; structurals; structurals &= structurals - 1) {
+            *out++ = static_cast<std::uint32_t>(base + std::countr_zero(structurals));
+        }
+    };
+    std::size_t pos = 0ul;
+    for (; pos + 64 <= input.size(); pos += 64) {
+        process(input.data() + pos, pos);
+    }
+    if (pos < input.size()) {
+        char tail[64];
+        std::memset(tail, ' ', sizeof(tail));
+        std::memcpy(tail, input.data() + pos, input.size() - pos);
+        process(tail, pos);
+    }
+    index.resize(count);
+}
+
+// Converts a number token that already matched the JSON grammar into T.
+// Integers of up to 19 digits are accumulated directly; longer ones and
+// floating-point values go through std::from_chars, which is locale
+// independent and rounds correctly. Values that do not fit T yield
+// std::errc::result_out_of_range.
+template <numeric_except_bool T>
+inline std::errc parse_number(std::string_view number, T& out) {
+    const char* first = number.data();
+    const char* last = first + number.size();
+    if constexpr (std::is_integral_v<T>) {
+        bool negative = *first == '-';
+        const char* digits = first + negative;
+        if (last - digits > 19) {
+            auto [ptr, ec] = std::from_chars(first, last, out);
+            return ptr == last ? ec : std::errc::invalid_argument;
+        }
+        std::uint64_t value = 0;
+        for (const char* it = digits; it != last; ++it) {
+            value = value * 10 + static_cast<std::uint64_t>(*it - '0');
+        }
+        constexpr auto max_value = static_cast<std::uint64_t>(std::numeric_limits<T>::max());
+        if (!negative) {
+            if (value > max_value) { return std::errc::result_out_of_range; }
+            out = static_cast<T>(value);
+        } else if constexpr (std::is_unsigned_v<T>) {
+            if (value != 0) { return std::errc::result_out_of_range; }
+            out = 0;
+        } else {
+            if (value > max_value + 1) { return std::errc::result_out_of_range; }
+            out = static_cast<T>(0 - static_cast<std::make_unsigned_t<T>>(value));
+        }
+        return {};
+    } else {
+        auto [ptr, ec] = std::from_chars(first, last, out);
+        return ptr == last ? ec : std::errc::invalid_argument;
+    }
+}
+
+inline bool read_hex4(const char* p, std::uint32_t& out) {
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = p[i];
+        std::uint32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = static_cast<std::uint32_t>(c - '0');
+        } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+            digit = static_cast<std::uint32_t>((c | 0x20) - 'a' + 10);
+        } else {
+            return false;
+        }
+        out = out << 4 | digit;
+    }
+    return true;
+}
+
+inline char* write_utf8(std::uint32_t code_point, char* out) {
+    if (code_point < 0x80) {
+        *out++ = static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+        *out++ = static_cast<char>(0xc0 | code_point >> 6);
+        *out++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    } else if (code_point < 0x10000) {
+        *out++ = static_cast<char>(0xe0 | code_point >> 12);
+        *out++ = static_cast<char>(0x80 | (code_point >> 6 & 0x3f));
+        *out++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    } else {
+        *out++ = static_cast<char>(0xf0 | code_point >> 18);
+        *out++ = static_cast<char>(0x80 | (code_point >> 12 & 0x3f));
+        *out++ = static_cast<char>(0x80 | (code_point >> 6 & 0x3f));
+        *out++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+    return out;
+}
+
+// Decodes the escape sequence starting at the backslash `p` into `out`, at
+// most 4 bytes, and advances `out`. Returns the byte after the sequence, or
+// nullptr for an invalid escape or an unpaired surrogate.
+inline const char* read_escape(const char* p, const char* end, char*& out) {
+    if (end - p < 2) { return nullptr; }
+    char escape = p[1];
+    p += 2;
+    switch (escape) {
+        case '"': *out++ = '"'; return p;
+        case '\\': *out++ = '\\'; return p;
+        case '/': *out++ = '/'; return p;
+        case 'b': *out++ = '\b'; return p;
+        case 'f': *out++ = '\f'; return p;
+        case 'n': *out++ = '\n'; return p;
+        case 'r': *out++ = '\r'; return p;
+        case 't': *out++ = '\t'; return p;
+        case 'u': {
+            std::uint32_t code_point;
+            if (end - p < 4 || !read_hex4(p, code_point)) { return nullptr; }
+            p += 4;
+            if (code_point >= 0xd800 && code_point < 0xdc00) {
+                std::uint32_t low;
+                if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || !read_hex4(p + 2, low) ||
+                    low < 0xdc00 || low >= 0xe000) {
+                    return nullptr;
+                }
+                p += 6;
+                code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+            } else if (code_point >= 0xdc00 && code_point < 0xe000) {
+                return nullptr;
+            }
+            out = write_utf8(code_point, out);
+            return p;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+// Decodes the escapes of `raw`, a string token without its quotes whose
+// first backslash or control character is at `first_escape` (as found by
+// find_escape()), into `out`. No escape decodes to more bytes than it
+// takes, so `out` needs room for raw.size() bytes. Returns the end of the
+// decoded bytes, or nullptr for an invalid escape, an unpaired surrogate or
+// an unescaped control character.
+inline char* unescape(std::string_view raw, std::size_t first_escape, char* out) {
+    const char* p = raw.data();
+    const char* end = p + raw.size();
+    std::size_t run = first_escape;
+    while (true) {
+        std::memcpy(out, p, run);
+        out += run;
+        p += run;
+        if (p == end) { return out; }
+        if (*p != '\\') { return nullptr; }
+        p = read_escape(p, end, out);
+        if (!p) { return nullptr; }
+        run = find_escape(p, static_cast<std::size_t>(end - p));
+    }
+}
+
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+inline Token classify_number(std::string_view number) {
+    std::size_t it = 0ul;
+    auto digits = [&] {
+        std::size_t start = it;
+        while (it < number.size() && number[it] >= '0' && number[it] <= '9') { ++it; }
+        return it - start;
+    };
+    if (it < number.size() && number[it] == '-') { ++it; }
+    if (it < number.size() && number[it] == '0') {
+        ++it;
+    } else if (digits() == 0) {
+        return Token::INVALID;
+    }
+    bool integral = true;
+    if (it < number.size() && number[it] == '.') {
+        ++it;
+        if (digits() == 0) { return Token::INVALID; }
+        integral = false;
+    }
+    if (it < number.size() && (number[it] == 'e' || number[it] == 'E')) {
+        ++it;
+        if (it < number.size() && (number[it] == '+' || number[it] == '-')) { ++it; }
+        if (digits() == 0) { return Token::INVALID; }
+        integral = false;
+    }
+    if (it != number.size()) { return Token::INVALID; }
+    return integral ? Token::NUMBER_INT : Token::NUMBER_FLOAT;
+}
+
+// Whether the string token `raw` holds an unescaped control character.
+inline bool has_control(std::string_view raw) {
+    std::size_t i = find_escape(raw.data(), raw.size());
+    while (i < raw.size()) {
+        if (raw[i] != '\\') { return true; }
+        // Skip the escaped character; the digits of \uXXXX are never controls.
+        i += 2;
+        if (i >= raw.size()) { return false; }
+        i += find_escape(raw.data() + i, raw.size() - i);
+    }
+    return false;
+}
+
+inline bool unescape_into(std::string& out, std::string_view raw, std::size_t first_escape) {
+    out.resize(raw.size());
+    char* end = unescape(raw, first_escape, out.data());
+    if (!end) { return false; }
+    out.resize(static_cast<std::size_t>(end - out.data()));
+    return true;
+}
+
 class Tokenizer {
 public:
     std::string_view sv;
-    Token token;
+    Token token = Token::END;
+    // Where escaped strings bound to std::string_view fields are decoded.
+    std::pmr::memory_resource* string_arena = nullptr;
+    // Objects and arrays the typed deserializer is inside, and its limit.
+    std::size_t depth = 0ul;
+    std::size_t max_depth = default_max_depth;
+
+    Tokenizer(std::string_view input) : sv(input) {
+        index_structurals(sv, index);
+        entries = index;
+    }
+
+    // Builds the index in `storage`, reusing its capacity.
+    Tokenizer(std::string_view input, std::pmr::vector<std::uint32_t> storage)
+        : sv(input), index(std::move(storage)) {
+        index_structurals(sv, index);
+        entries = index;
+    }
+
+    // Walks a slice of an index built over the same `input` by another Tokenizer.
+    Tokenizer(std::string_view input, std::span<const std::uint32_t> borrowed)
+        : sv(input), entries(borrowed) { }
+
+    Tokenizer(const Tokenizer&) = delete;
+    Tokenizer& operator=(const Tokenizer&) = delete;
+    Tokenizer(Tokenizer&&) = default;
+    Tokenizer& operator=(Tokenizer&&) = default;
+
+    inline std::pmr::vector<std::uint32_t> release_index() {
+        entries = {};
+        return std::move(index);
+    }
 
-    Tokenizer(std::string_view input) : sv(input) { }
+    inline std::span<const std::uint32_t> structurals() const { return entries; }
     
-    inline bool is_end() {
-        skip_whitespaces();
-        return token_current == sv.length();
+    inline bool is_end() const { return cursor >= entries.size(); }
+
+    // Index entry of the current token.
+    inline std::size_t position() const { return cursor; }
+
+    // Offset in the input of the first byte of the current token (the
+    // opening quote of a string), or the input size at the end.
+    inline std::size_t offset() const { return is_end() ? sv.length() : entries[cursor]; }
+
+    // Moves past the bracket that closes the innermost open container, which
+    // `open` ('{' or '[') opened, matching bracket kinds on the raw index
+    // entries without classifying anything in between; quotes inside strings
+    // are never index entries. Returns 1 if the input ends first or a bracket
+    // closes the wrong kind of container, and 7 if the skipped containers
+    // nest deeper than max_depth or, since their kinds are one bit each of a
+    // fixed stack, default_max_depth.
+    inline int skip_past_close(char open) {
+        std::array<std::uint64_t, default_max_depth / 64> objects{};  // bit set: the level is an object
+        std::size_t limit = std::min(max_depth - std::min(depth, max_depth), default_max_depth);
+        std::size_t level = 0ul;
+        objects[0] = open == '{';
+        for (; cursor < entries.size(); ++cursor) {
+            char c = sv[entries[cursor]];
+            switch (c) {
+                case '{':
+                case '[': {
+                    if (++level >= limit) { return 7; }
+                    std::uint64_t bit = std::uint64_t{1} << (level % 64);
+                    auto& word = objects[level / 64];
+                    word = c == '{' ? word | bit : word & ~bit;
+                    break;
+                }
+                case '}':
+                case ']':
+                    if ((objects[level / 64] >> (level % 64) & 1) != (c == '}')) { return 1; }
+                    if (level-- == 0) {
+                        ++cursor;
+                        next();
+                        return 0;
+                    }
+                    break;
+                case '"':
+                    ++cursor;
+                    break;
+            }
+        }
+        next();
+        return 1;
     }
 
-    inline void skip() { update_current_pos(); }
+    inline void skip() { cursor += token == Token::STRING ? 2 : 1; }
+
+    // Counts a level of nesting for the typed deserializer; false once
+    // max_depth levels are open.
+    inline bool enter() {
+        if (depth == max_depth) { return false; }
+        ++depth;
+        return true;
+    }
+
+    // Moves past the bracket that closes the current level.
+    inline void leave() {
+        --depth;
+        skip_to_next();
+    }
 
     inline void skip_to_next() { skip(); next(); }
 
     inline std::string_view get_sv() {
-        std::size_t start = token_current;
-        update_current_pos();
-        return sv.substr(start, token_current - start);
+        std::string_view value = sv.substr(token_current, token_end - token_current);
+        skip();
+        return value;
     }
     
-    inline double get_float() { return std::strtod(get_sv().data(), nullptr); }
-
-    inline std::int64_t get_int() { return std::strtoll(get_sv().data(), nullptr, 10); }
+    template <numeric_except_bool T>
+    inline std::errc get_number(T& out) { return parse_number(get_sv(), out); }
 
     void next() {
-        skip_whitespaces();
+        if (is_end()) {
+            token = Token::END;
+            token_current = token_end = sv.length();
+            return;
+        }
+        token_current = entries[cursor];
+        token_end = token_current + 1;
         switch (sv[token_current]) {
             case '{':
                token = Token::CURLY_OPEN;
@@ -201,424 +1178,2941 @@ public:
             case ':':
                 token = Token::COLON;
                 return;
-            case '"':
-                token = Token::QUOTE;
-                return;
             case ',':
                 token = Token::COMMA;
                 return;
+            case '"':
+                // The closing quote is always the next index entry.
+                token_current += 1;
+                if (cursor + 1 < entries.size()) {
+                    token_end = entries[cursor + 1];
+                    token = Token::STRING;
+                } else {
+                    token_end = sv.length();
+                    token = Token::INVALID;
+                }
+                return;
+        }
+        std::size_t limit = cursor + 1 < entries.size() ? entries[cursor + 1] : sv.length();
+        token_end = token_current;
+        while (token_end < limit && !ends_literal(sv[token_end])) {
+            ++token_end;
         }
-        if (try_read_null() != token_current) {
-            token_end = token_current + 4;
+        std::string_view literal = sv.substr(token_current, token_end - token_current);
+        if (literal == "null") {
             token = Token::NULL_TOKEN;
-        } else if (try_read_true() != token_current) {
-            token_end = token_current + 4;
+        } else if (literal == "true") {
             token = Token::BOOL_TRUE;
-        } else if (try_read_false() != token_current) {
-            token_end = token_current + 5;
+        } else if (literal == "false") {
             token = Token::BOOL_FALSE;
-        } else if ((token_end = try_read_number()) && token_end != token_current) {
-            auto number_token = sv.substr(token_current, token_end - token_current);
-            if (number_token.find_first_of(".eE") != std::string_view::npos) {
-                token = Token::NUMBER_FLOAT;
+        } else {
+            token = classify_number(literal);
+        }
+    }
+
+private:
+    std::pmr::vector<std::uint32_t> index;
+    std::span<const std::uint32_t> entries;
+    std::size_t cursor = 0ul;
+    std::size_t token_current = 0ul;
+    std::size_t token_end = 0ul;
+};
+
+// Skips the value at the current token and leaves the tokenizer on the
+// token that follows it. Objects and arrays are skipped by matching brackets
+// over the index, without classifying their contents.
+inline int skip_value(Tokenizer& tokenizer) {
+    switch (tokenizer.token) {
+        case Token::CURLY_OPEN:
+        case Token::SQUARE_OPEN: {
+            char open = tokenizer.token == Token::CURLY_OPEN ? '{' : '[';
+            tokenizer.skip();
+            return tokenizer.skip_past_close(open);
+        }
+        case Token::CURLY_CLOSE:
+        case Token::SQUARE_CLOSE:
+        case Token::COLON:
+        case Token::COMMA:
+        case Token::END:
+        case Token::INVALID:
+            return 1;
+        default:
+            tokenizer.skip_to_next();
+            return 0;
+    }
+}
+
+// Adds the input size, index entries, value count and nesting depth of the
+// input indexed by `tokenizer` to `sink`. Only runs when a sink is given,
+// as a separate pass over the index.
+inline void record_input(stats& sink, const Tokenizer& tokenizer) {
+    std::string_view input = tokenizer.sv;
+    std::span<const std::uint32_t> entries = tokenizer.structurals();
+    std::size_t depth = 0ul;
+    sink.bytes_read += input.size();
+    sink.tokens += entries.size();
+    for (std::size_t e = 0; e < entries.size(); ++e) {
+        switch (input[entries[e]]) {
+            case '{':
+            case '[':
+                ++sink.nodes;
+                sink.max_depth = std::max(sink.max_depth, ++depth);
+                break;
+            case '}':
+            case ']':
+                if (depth) { --depth; }
+                break;
+            case ',':
+            case ':':
+                break;
+            case '"':
+                // A string followed (after its closing quote) by ':' is a key.
+                if (e + 2 >= entries.size() || input[entries[e + 2]] != ':') { ++sink.nodes; }
+                ++e;
+                break;
+            default:
+                ++sink.nodes;
+        }
+    }
+}
+
+inline constexpr std::uint64_t key_hash(std::string_view key) {
+    std::uint64_t h = 0xcbf29ce484222325ull ^ key.size();
+    for (char c : key) {
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+inline constexpr std::uint64_t mix_seed(std::uint64_t h, std::uint64_t seed) {
+    h ^= seed * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+// Compile-time minimal-collision hash from member name to member index. Keys
+// are split into buckets by their hash; each bucket gets a seed that places
+// all of its keys in free slots, so a lookup is one hash, one table read and
+// one comparison against the candidate name.
+template <typename T>
+struct member_index {
+    static constexpr std::size_t count = reflect::size<T>();
+
+    static constexpr auto names = [] {
+        std::array<std::string_view, count> result{};
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ((result[I] = reflect::member_name<I, T>()), ...);
+        }(std::make_index_sequence<count>{});
+        return result;
+    }();
+
+    static constexpr std::size_t buckets = count ? count : 1;
+    static constexpr std::size_t table_size = std::bit_ceil(buckets) * 2;
+
+    struct layout {
+        std::array<std::uint16_t, buckets> seeds{};
+        std::array<std::uint16_t, table_size> slots{};
+        bool perfect = false;
+    };
+
+    static constexpr std::size_t slot(std::uint64_t hash, std::uint64_t seed) {
+        return static_cast<std::size_t>(mix_seed(hash, seed) & (table_size - 1));
+    }
+
+    static constexpr layout table = [] {
+        layout result{};
+        result.slots.fill(static_cast<std::uint16_t>(count));
+        std::array<std::uint64_t, count> hashes{};
+        std::array<std::size_t, buckets> bucket_sizes{};
+        for (std::size_t i = 0; i < count; ++i) {
+            hashes[i] = key_hash(names[i]);
+            ++bucket_sizes[hashes[i] % buckets];
+        }
+        std::array<std::size_t, buckets> order{};
+        for (std::size_t b = 0; b < buckets; ++b) { order[b] = b; }
+        std::sort(order.begin(), order.end(), [&](std::size_t l, std::size_t r) {
+            return bucket_sizes[l] > bucket_sizes[r];
+        });
+        for (std::size_t bucket : order) {
+            if (bucket_sizes[bucket] == 0) { break; }
+            bool placed = false;
+            for (std::uint32_t seed = 0; seed <= 0xffff && !placed; ++seed) {
+                placed = true;
+                for (std::size_t i = 0; i < count && placed; ++i) {
+                    if (hashes[i] % buckets != bucket) { continue; }
+                    auto& entry = result.slots[slot(hashes[i], seed)];
+                    if (entry != count) {
+                        placed = false;
+                    } else {
+                        entry = static_cast<std::uint16_t>(i);
+                    }
+                }
+                if (!placed) {
+                    for (auto& entry : result.slots) {
+                        if (entry != count && hashes[entry] % buckets == bucket) { entry = static_cast<std::uint16_t>(count); }
+                    }
+                } else {
+                    result.seeds[bucket] = static_cast<std::uint16_t>(seed);
+                }
+            }
+            if (!placed) { return result; }
+        }
+        result.perfect = true;
+        return result;
+    }();
+
+    // Index of the member named `key`, or `count` if there is none.
+    static constexpr std::size_t find(std::string_view key) {
+        if constexpr (count == 0) {
+            return 0;
+        } else {
+            if (!table.perfect) {
+                return static_cast<std::size_t>(std::find(names.begin(), names.end(), key) - names.begin());
+            }
+            std::uint64_t hash = key_hash(key);
+            std::size_t candidate = table.slots[slot(hash, table.seeds[hash % buckets])];
+            return candidate < count && names[candidate] == key ? candidate : count;
+        }
+    }
+
+    // Producers usually emit keys in declaration order, so the member after
+    // the previous one is checked before hashing.
+    static constexpr std::size_t find(std::string_view key, std::size_t expected) {
+        if (expected < count && names[expected] == key) { return expected; }
+        return find(key);
+    }
+};
+
+template <typename To>
+struct deserializer_impl {
+    static int deserialize(To& obj, Tokenizer& tokenizer) {
+        if (tokenizer.token != Token::CURLY_OPEN) { return 1; }
+        if (!tokenizer.enter()) { return 7; }
+        tokenizer.skip_to_next();
+        if (tokenizer.token == Token::CURLY_CLOSE) {
+            tokenizer.leave();
+            return 0;
+        }
+        std::size_t expected = 0ul;
+        while (true) {
+            if (tokenizer.token != Token::STRING) { return 1; }
+            std::string_view key = tokenizer.get_sv();
+            tokenizer.next();
+            if (tokenizer.token != Token::COLON || has_control(key)) { return 1; }
+            tokenizer.skip_to_next();
+
+            std::size_t index = member_index<To>::find(key, expected);
+            int err = index < member_index<To>::count ? readers[index](obj, tokenizer)
+                                                      : skip_value(tokenizer);
+            if (err) { return err; }
+            expected = index + 1;
+
+            if (tokenizer.token == Token::COMMA) {
+                tokenizer.skip_to_next();
+            } else if (tokenizer.token == Token::CURLY_CLOSE) {
+                tokenizer.leave();
+                return 0;
+            } else {
+                return 1;
+            }
+        }
+    }
+
+private:
+    template <std::size_t I>
+    static int read_member(To& obj, Tokenizer& tokenizer) {
+        auto& ith_member = reflect::get<I>(obj);
+        using member_t = std::remove_cvref_t<decltype(ith_member)>;
+        return deserializer_impl<member_t>::deserialize(ith_member, tokenizer);
+    }
+
+    using member_reader = int (*)(To&, Tokenizer&);
+
+    static constexpr auto readers = []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<member_reader, sizeof...(I)>{&read_member<I>...};
+    }(std::make_index_sequence<member_index<To>::count>{});
+};   
+
+template <sized_forward_range To>
+struct deserializer_impl<To> {
+    static int deserialize(To& obj, Tokenizer& tokenizer) {
+        using value_t = std::ranges::range_value_t<To>;
+        if (tokenizer.token != Token::SQUARE_OPEN) { return 1; }
+        if (!tokenizer.enter()) { return 7; }
+        tokenizer.skip_to_next();
+        if (tokenizer.token == Token::SQUARE_CLOSE) {
+            tokenizer.leave();
+            return 0;
+        }
+        auto it = std::ranges::begin(obj);
+        auto end = std::ranges::end(obj);
+        while (true) {
+            if (it == end) { return 1; }
+            int err = deserializer_impl<value_t>::deserialize(*it, tokenizer);
+            if (err) { return err; }
+            ++it;
+
+            if (tokenizer.token == Token::COMMA) {
+                tokenizer.skip_to_next();
+            } else if (tokenizer.token == Token::SQUARE_CLOSE) {
+                tokenizer.leave();
+                return 0;
+            } else {
+                return 1;
+            }
+        }
+    }
+};
+
+// Resizable containers are filled in place: existing elements are
+// deserialized over, so their own capacity (nested strings and vectors) is
+// reused, new ones are appended and extra ones are erased at the end.
+template <resizable_range To>
+struct deserializer_impl<To> {
+    static int deserialize(To& obj, Tokenizer& tokenizer) {
+        using value_t = std::ranges::range_value_t<To>;
+        if (tokenizer.token != Token::SQUARE_OPEN) { return 1; }
+        if (!tokenizer.enter()) { return 7; }
+        tokenizer.skip_to_next();
+        std::size_t count = 0ul;
+        if (tokenizer.token == Token::SQUARE_CLOSE) {
+            tokenizer.leave();
+            obj.resize(count);
+            return 0;
+        }
+        std::size_t size = std::ranges::size(obj);
+        auto it = std::ranges::begin(obj);
+        while (true) {
+            value_t& element = count < size ? *it++ : obj.emplace_back();
+            ++count;
+            int err = deserializer_impl<value_t>::deserialize(element, tokenizer);
+            if (err) { return err; }
+
+            if (tokenizer.token == Token::COMMA) {
+                tokenizer.skip_to_next();
+            } else if (tokenizer.token == Token::SQUARE_CLOSE) {
+                tokenizer.leave();
+                if (count < size) { obj.resize(count); }
+                return 0;
+            } else {
+                return 1;
+            }
+        }
+    }
+};
+
+// Fills a string-keyed map in place. Values of keys that are already present
+// are deserialized over, reusing their capacity; finish() erases the keys
+// the input no longer has. A map that started empty has nothing to erase.
+// Keys may repeat, as RFC 8259 allows; the last value wins.
+template <string_keyed_map Map>
+class MapFiller {
+public:
+    explicit MapFiller(Map& map) : map(map), base(seen_keys().size()), size_before(map.size()) { }
+    ~MapFiller() { seen_keys().resize(base); }
+
+    MapFiller(const MapFiller&) = delete;
+    MapFiller& operator=(const MapFiller&) = delete;
+
+    // `key` is decoded and only needs to live until the call returns.
+    typename Map::mapped_type& slot(std::string_view key) {
+        thread_local typename Map::key_type lookup;
+        lookup = key;
+        auto entry = map.try_emplace(lookup).first;
+        seen_keys().push_back(std::string_view{entry->first});
+        return entry->second;
+    }
+
+    void finish() {
+        if (size_before == 0) { return; }
+        auto first = seen_keys().begin() + static_cast<std::ptrdiff_t>(base);
+        auto last = seen_keys().end();
+        std::sort(first, last);
+        last = std::unique(first, last);
+        if (static_cast<std::size_t>(last - first) == map.size()) { return; }
+        for (auto entry = map.begin(); entry != map.end();) {
+            if (std::binary_search(first, last, std::string_view{entry->first})) {
+                ++entry;
+            } else {
+                entry = map.erase(entry);
+            }
+        }
+    }
+
+private:
+    Map& map;
+    std::size_t base;
+    std::size_t size_before;
+
+    // Keys of the maps being filled on this thread, innermost last. They view
+    // the keys in the maps, which node-based maps keep in place, and the
+    // vector keeps its capacity between calls.
+    static std::vector<std::string_view>& seen_keys() {
+        thread_local std::vector<std::string_view> keys;
+        return keys;
+    }
+};
+
+// Reads an object key into `key`. Escaped keys are decoded like strings: into
+// the string arena for maps keyed by std::string_view, otherwise into a
+// scratch string that the next key overwrites.
+template <any_string Key>
+inline int read_key(std::string_view& key, Tokenizer& tokenizer) {
+    if constexpr (std::same_as<Key, std::string_view>) {
+        return deserializer_impl<Key>::deserialize(key, tokenizer);
+    } else {
+        thread_local std::string decoded;
+        if (tokenizer.token != Token::STRING) { return 1; }
+        key = tokenizer.get_sv();
+        tokenizer.next();
+        std::size_t escape = find_escape(key.data(), key.size());
+        if (escape == key.size()) { return 0; }
+        if (!unescape_into(decoded, key, escape)) { return 1; }
+        key = decoded;
+        return 0;
+    }
+}
+
+template <string_keyed_map To>
+struct deserializer_impl<To> {
+    static int deserialize(To& obj, Tokenizer& tokenizer) {
+        using mapped_t = typename To::mapped_type;
+        if (tokenizer.token != Token::CURLY_OPEN) { return 1; }
+        if (!tokenizer.enter()) { return 7; }
+        tokenizer.skip_to_next();
+        MapFiller<To> filler(obj);
+        if (tokenizer.token == Token::CURLY_CLOSE) {
+            tokenizer.leave();
+            filler.finish();
+            return 0;
+        }
+        while (true) {
+            std::string_view key;
+            if (int err = read_key<typename To::key_type>(key, tokenizer)) { return err; }
+            if (tokenizer.token != Token::COLON) { return 1; }
+            tokenizer.skip_to_next();
+            int err = deserializer_impl<mapped_t>::deserialize(filler.slot(key), tokenizer);
+            if (err) { return err; }
+
+            if (tokenizer.token == Token::COMMA) {
+                tokenizer.skip_to_next();
+            } else if (tokenizer.token == Token::CURLY_CLOSE) {
+                tokenizer.leave();
+                filler.finish();
+                return 0;
             } else {
-                token = Token::NUMBER_INT;
+                return 1;
+            }
+        }
+    }
+};
+
+template <numeric_except_bool To>
+struct deserializer_impl<To> {
+    static int deserialize(To& obj, Tokenizer& tokenizer) {
+        bool matches = tokenizer.token == Token::NUMBER_INT ||
+                       (std::is_floating_point_v<To> && tokenizer.token == Token::NUMBER_FLOAT);
+        if (!matches) { return 1; }
+        if (tokenizer.get_number(obj) != std::errc{}) { return 3; }
+        tokenizer.next();
+        return 0;
+    }
+};
+
+template <>
+struct deserializer_impl<bool> {
+    static int deserialize(bool& obj, Tokenizer& tokenizer) {
+        if (tokenizer.token != Token::BOOL_TRUE && tokenizer.token != Token::BOOL_FALSE) {
+            return 1;
+        }
+        obj = tokenizer.token == Token::BOOL_TRUE;
+        tokenizer.skip_to_next();
+        return 0;
+    }
+};
+
+// Strings without escapes are assigned straight from the input, so
+// std::string_view fields point into it. Escaped strings are decoded into
+// std::string fields, reusing their capacity; a std::string_view field gets
+// them decoded into the tokenizer's string arena and is an error without one.
+// Unescaped control characters are an error, as in every other entry point.
+template <any_string To>
+struct deserializer_impl<To> {
+    static int deserialize(To& obj, Tokenizer& tokenizer) {
+        if (tokenizer.token != Token::STRING) { return 1; }
+        std::string_view raw = tokenizer.get_sv();
+        tokenizer.next();
+        std::size_t escape = find_escape(raw.data(), raw.size());
+        if (escape == raw.size()) {
+            obj = raw;
+            return 0;
+        }
+        if constexpr (std::same_as<To, std::string_view>) {
+            if (!tokenizer.string_arena) { return 1; }
+            char* decoded = static_cast<char*>(tokenizer.string_arena->allocate(raw.size(), 1));
+            char* end = unescape(raw, escape, decoded);
+            if (!end) { return 1; }
+            obj = std::string_view{decoded, static_cast<std::size_t>(end - decoded)};
+        } else if constexpr (std::same_as<To, std::string>) {
+            if (!unescape_into(obj, raw, escape)) { return 1; }
+        } else {
+            thread_local std::string decoded;
+            if (!unescape_into(decoded, raw, escape)) { return 1; }
+            obj = decoded;
+        }
+        return 0;
+    }
+};
+
+// The value runs from its first token to the token after it, less the
+// whitespace in between.
+template <>
+struct deserializer_impl<raw_json> {
+    static int deserialize(raw_json& obj, Tokenizer& tokenizer) {
+        std::size_t start = tokenizer.offset();
+        if (int err = skip_value(tokenizer)) { return err; }
+        std::size_t end = tokenizer.offset();
+        while (end > start && is_whitespace(tokenizer.sv[end - 1])) { --end; }
+        obj = raw_json{tokenizer.sv.substr(start, end - start)};
+        return 0;
+    }
+};
+
+template <typename To>
+struct deserializer_impl<std::optional<To>> {
+    static int deserialize(std::optional<To>& to, Tokenizer& tokenizer) {
+        if (tokenizer.token == Token::NULL_TOKEN) {
+            to.reset();
+            tokenizer.skip_to_next();
+            return 0;
+        }
+        if (!to) { to.emplace(); }
+        return deserializer_impl<To>::deserialize(*to, tokenizer);
+    }
+};
+
+template <typename To>
+int deserialize_document(To& to, Tokenizer& tokenizer) {
+    tokenizer.next();
+    int err = deserializer_impl<To>::deserialize(to, tokenizer);
+    if (err) { return err; }
+    if (!tokenizer.is_end()) { return 2; }
+    return 0;
+}
+} //namespace detail
+
+// Fills `to` directly from the tokens of `json`, without building a DOM.
+// Members missing from the input keep their values and the values of
+// unknown keys are skipped by bracket counting, without being checked.
+// Resizable containers and string-keyed maps take the size of the input,
+// reusing the capacity they already have.
+// Returns 0 on success, 1 if the input does not match the type, 2 if
+// anything follows the value, 3 if a number does not fit its field, 7 if
+// the input nests deeper than default_max_depth and 8 if it is larger than
+// max_input_size.
+template <typename To>
+int deserialize(To& to, std::string_view json) {
+    if (json.size() > max_input_size) { return 8; }
+    // The index storage is kept per thread so that steady-state calls do not allocate.
+    thread_local std::pmr::vector<std::uint32_t> index;
+    detail::Tokenizer tokenizer(json, std::move(index));
+    int err = detail::deserialize_document(to, tokenizer);
+    index = tokenizer.release_index();
+    return err;
+}
+
+// As above, with the token index allocated from `opts.resource`, nesting
+// limited to `opts.max_depth` and the call measured into `opts.sink` when
+// one is given.
+template <typename To>
+int deserialize(To& to, std::string_view json, const options& opts) {
+    if (json.size() > max_input_size) { return 8; }
+    detail::CountingResource counter(opts.resource);
+    detail::Stopwatch watch(opts.sink);
+    detail::Tokenizer tokenizer(json, std::pmr::vector<std::uint32_t>(opts.sink ? &counter : opts.resource));
+    tokenizer.string_arena = opts.string_arena;
+    tokenizer.max_depth = opts.max_depth;
+    watch.lap(&stats::tokenize_time);
+    int err = detail::deserialize_document(to, tokenizer);
+    watch.lap(&stats::bind_time);
+    if (opts.sink) {
+        detail::record_input(*opts.sink, tokenizer);
+        detail::record_allocations(*opts.sink, counter);
+    }
+    return err;
+}
+
+template <typename T>
+int raw_json::parse_as(T& out) const {
+    return deserialize(out, text);
+}
+
+namespace detail {
+
+template <typename T>
+concept reflected_aggregate = std::is_aggregate_v<T> && std::is_class_v<T> &&
+                              (not sized_forward_range<T>) && (not any_string<T>);
+
+template <typename T>
+bool values_equal(const T& a, const T& b) {
+    if constexpr (std::floating_point<T>) {
+        return a == b || (std::isnan(a) && std::isnan(b));
+    } else if constexpr (numeric<T> || any_string<T> || std::same_as<T, raw_json>) {
+        return a == b;
+    } else if constexpr (is_optional<T>::value) {
+        return a.has_value() == b.has_value() && (!a || values_equal(*a, *b));
+    } else if constexpr (string_keyed_map<T>) {
+        if (a.size() != b.size()) { return false; }
+        for (auto& [key, value] : a) {
+            auto other = b.find(key);
+            if (other == b.end() || !values_equal(value, other->second)) { return false; }
+        }
+        return true;
+    } else if constexpr (sized_forward_range<T>) {
+        if (std::ranges::size(a) != std::ranges::size(b)) { return false; }
+        auto other = std::ranges::begin(b);
+        for (auto& element : a) {
+            if (!values_equal(element, *other)) { return false; }
+            ++other;
+        }
+        return true;
+    } else {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return (values_equal(reflect::get<I>(a), reflect::get<I>(b)) && ...);
+        }(std::make_index_sequence<member_keys<T>::count>{});
+    }
+}
+
+// Writes the members of `curr` that differ from `prev` as a JSON object.
+// Nested aggregates, and optionals holding one on both sides, are written
+// as deltas themselves; any other changed member is written in full.
+template <reflected_aggregate T>
+struct delta_impl {
+    template <typename Stream>
+    static void serialize(const T& prev, const T& curr, Stream& stream) {
+        char separator = '{';
+        if constexpr (member_keys<T>::count > 0) {
+            reflect::for_each([&](auto I) {
+                auto& before = reflect::get<I>(prev);
+                auto& after = reflect::get<I>(curr);
+                using member_t = std::remove_cvref_t<decltype(after)>;
+                if (values_equal(before, after)) { return; }
+                // Fragments start with their own '{' or ','.
+                constexpr std::string_view key = member_keys<T>::template key<I>();
+                stream.put(separator);
+                stream.write(key.data() + 1, key.size() - 1);
+                separator = ',';
+                if constexpr (reflected_aggregate<member_t>) {
+                    delta_impl<member_t>::serialize(before, after, stream);
+                } else if constexpr (is_optional<member_t>::value) {
+                    using value_t = typename member_t::value_type;
+                    if constexpr (reflected_aggregate<value_t>) {
+                        if (before && after) {
+                            delta_impl<value_t>::serialize(*before, *after, stream);
+                            return;
+                        }
+                    }
+                    serializer_impl<member_t>::serialize(after, stream);
+                } else {
+                    serializer_impl<member_t>::serialize(after, stream);
+                }
+            }, curr);
+        }
+        if (separator == '{') { stream.put('{'); }
+        stream.put('}');
+    }
+};
+} // namespace detail
+
+// Writes only the members of `curr` that differ from `prev`, recursing into
+// nested aggregates and optionals; `{}` if nothing changed.
+template <typename T, typename Stream>
+void serialize_delta_into(const T& prev, const T& curr, Stream& out) {
+    detail::delta_impl<T>::serialize(prev, curr, out);
+}
+
+template <typename T>
+std::string serialize_delta(const T& prev, const T& curr) {
+    buffer out;
+    serialize_delta_into(prev, curr, out);
+    return out.str();
+}
+
+// Applies a delta from serialize_delta() to `obj`, which must hold the
+// `prev` snapshot. deserialize() already leaves members missing from the
+// input untouched and fills nested aggregates member by member, so a delta
+// goes through the same member dispatch. Returns the deserialize() codes.
+template <typename To>
+int apply_delta(To& obj, std::string_view delta) {
+    return deserialize(obj, delta);
+}
+
+// Outcome of validate(): 0 if the input is one well-formed JSON value, 1 if
+// it is malformed (grammar, numbers, escapes or UTF-8), 2 if anything but
+// whitespace follows the value and 7 if it nests deeper than the depth
+// limit; `offset` is where in the input the error was found.
+struct validate_result {
+    int error = 0;
+    std::size_t offset = 0ul;
+};
+
+namespace detail {
+
+// Offset of the first byte in data[0, size) that is not plain ASCII string
+// content (a quote, a backslash, a control character or a byte of a
+// multi-byte UTF-8 sequence), or size.
+inline std::size_t find_string_special(const char* data, std::size_t size) {
+    std::size_t i = 0ul;
+#if defined(__AVX2__)
+    const __m256i quote32 = _mm256_set1_epi8('\"');
+    const __m256i backslash32 = _mm256_set1_epi8('\\');
+    const __m256i control32 = _mm256_set1_epi8(0x1f);
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote32), _mm256_cmpeq_epi8(chunk, backslash32)),
+            _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control32), control32));
+        // Bytes from 0x80 up have their sign bit set.
+        auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(special, chunk)));
+        if (mask) { return i + std::countr_zero(mask); }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i quote16 = _mm_set1_epi8('\"');
+    const __m128i backslash16 = _mm_set1_epi8('\\');
+    const __m128i control16 = _mm_set1_epi8(0x1f);
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote16), _mm_cmpeq_epi8(chunk, backslash16)),
+            _mm_cmpeq_epi8(_mm_max_epu8(chunk, control16), control16));
+        auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(special, chunk)));
+        if (mask) { return i + std::countr_zero(mask); }
+    }
+#endif
+    for (; i < size; ++i) {
+        if (needs_escape(data[i]) || static_cast<unsigned char>(data[i]) >= 0x80) { return i; }
+    }
+    return size;
+}
+
+// Length of the well-formed UTF-8 sequence at `p`, or 0. Overlong forms,
+// surrogates and code points above U+10FFFF are ill-formed (RFC 3629).
+inline std::size_t utf8_sequence_length(const char* p, const char* end) {
+    auto byte = [&](std::size_t i) { return static_cast<unsigned char>(p[i]); };
+    unsigned char lead = byte(0);
+    std::size_t length;
+    unsigned char low = 0x80, high = 0xbf;  // range of the second byte
+    if (lead < 0x80) {
+        return 1;
+    } else if (lead >= 0xc2 && lead <= 0xdf) {
+        length = 2;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        length = 3;
+        if (lead == 0xe0) { low = 0xa0; }
+        if (lead == 0xed) { high = 0x9f; }
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        length = 4;
+        if (lead == 0xf0) { low = 0x90; }
+        if (lead == 0xf4) { high = 0x8f; }
+    } else {
+        return 0;
+    }
+    if (static_cast<std::size_t>(end - p) < length || byte(1) < low || byte(1) > high) { return 0; }
+    for (std::size_t i = 2; i < length; ++i) {
+        if ((byte(i) & 0xc0) != 0x80) { return 0; }
+    }
+    return length;
+}
+
+// Checks a document in one pass over its bytes without building an index
+// or allocating: the kind of each open container is one bit of a fixed
+// stack. Accepts exactly the documents parse() accepts whose strings are
+// well-formed UTF-8, which parse() does not check, and fails with the same
+// error code as parse() otherwise. The stack holds default_max_depth
+// levels, so deeper limits are lowered to that.
+class Validator {
+public:
+    Validator(std::string_view input, std::size_t max_depth)
+        : begin(input.data()), p(input.data()), end(input.data() + input.size()),
+          max_depth(std::min(max_depth, default_max_depth)) { }
+
+    validate_result run() {
+        State state = State::VALUE;
+        while (state != State::FAILED && skip_whitespace()) {
+            switch (state) {
+                case State::FIRST_VALUE_OR_END:
+                    if (*p == ']') {
+                        state = close(false);
+                        break;
+                    }
+                    [[fallthrough]];
+                case State::VALUE:
+                    state = value();
+                    break;
+                case State::FIRST_KEY_OR_END:
+                    if (*p == '}') {
+                        state = close(true);
+                        break;
+                    }
+                    [[fallthrough]];
+                case State::KEY:
+                    if (*p != '"') {
+                        state = fail(1);
+                    } else if (!string()) {
+                        state = State::FAILED;
+                    } else if (!skip_whitespace() || *p != ':') {
+                        state = fail(1);
+                    } else {
+                        ++p;
+                        state = State::VALUE;
+                    }
+                    break;
+                case State::AFTER_VALUE:
+                    if (*p == ',') {
+                        ++p;
+                        state = in_object() ? State::KEY : State::VALUE;
+                    } else if (*p == '}' || *p == ']') {
+                        state = close(*p == '}');
+                    } else {
+                        state = fail(1);
+                    }
+                    break;
+                default:
+                    state = fail(2);
+            }
+        }
+        if (state != State::FAILED && state != State::DONE) { fail(1); }
+        return result;
+    }
+
+private:
+    enum class State : char {
+        VALUE,
+        FIRST_VALUE_OR_END,  // after '['
+        FIRST_KEY_OR_END,    // after '{'
+        KEY,                 // after ',' in an object
+        AFTER_VALUE,
+        DONE,
+        FAILED
+    };
+
+    const char* begin;
+    const char* p;
+    const char* end;
+    std::size_t max_depth;
+    std::size_t depth = 0ul;
+    std::array<std::uint64_t, default_max_depth / 64> objects{};  // bit set: the level is an object
+    validate_result result;
+
+    State fail(int error) { return fail(error, p); }
+
+    bool reject() {
+        fail(1);
+        return false;
+    }
+
+    State fail(int error, const char* at) {
+        result = {error, static_cast<std::size_t>(at - begin)};
+        return State::FAILED;
+    }
+
+    // Moves to the next byte that is not whitespace; false at the end.
+    bool skip_whitespace() {
+        while (p != end && is_whitespace(*p)) { ++p; }
+        return p != end;
+    }
+
+    bool in_object() const { return objects[(depth - 1) / 64] >> ((depth - 1) % 64) & 1; }
+
+    State end_value() const { return depth == 0 ? State::DONE : State::AFTER_VALUE; }
+
+    State value() {
+        switch (*p) {
+            case '{':
+            case '[': {
+                if (depth == max_depth) { return fail(7); }
+                std::uint64_t bit = std::uint64_t{1} << (depth % 64);
+                auto& word = objects[depth / 64];
+                word = *p == '{' ? word | bit : word & ~bit;
+                ++depth;
+                return *p++ == '{' ? State::FIRST_KEY_OR_END : State::FIRST_VALUE_OR_END;
+            }
+            case '"':
+                return string() ? end_value() : State::FAILED;
+            case '}': case ']': case ':': case ',':
+                return fail(1);
+            default:
+                return literal();
+        }
+    }
+
+    State close(bool object) {
+        if (depth == 0 || in_object() != object) { return fail(1); }
+        --depth;
+        ++p;
+        return end_value();
+    }
+
+    State literal() {
+        const char* start = p;
+        while (p != end && !ends_literal(*p)) { ++p; }
+        std::string_view text{start, static_cast<std::size_t>(p - start)};
+        if (text == "null" || text == "true" || text == "false") { return end_value(); }
+        Token kind = classify_number(text);
+        // parse() keeps numbers as int64 or double and rejects those that fit
+        // neither; integers of up to 19 digits always fit a double.
+        double real;
+        if (kind == Token::INVALID ||
+            ((kind == Token::NUMBER_FLOAT || text.size() > 19) && parse_number(text, real) != std::errc{})) {
+            return fail(1, start);
+        }
+        return end_value();
+    }
+
+    // Checks a string from its opening quote, ASCII runs at a time, and
+    // leaves `p` after the closing quote.
+    bool string() {
+        ++p;
+        while (true) {
+            p += find_string_special(p, static_cast<std::size_t>(end - p));
+            if (p == end) { return reject(); }
+            if (*p == '"') {
+                ++p;
+                return true;
+            }
+            if (*p == '\\') {
+                char decoded[4];
+                char* out = decoded;
+                const char* next = read_escape(p, end, out);
+                if (!next) { return reject(); }
+                p = next;
+                continue;
+            }
+            std::size_t length = needs_escape(*p) ? 0 : utf8_sequence_length(p, end);
+            if (!length) { return reject(); }
+            p += length;
+        }
+    }
+};
+} // namespace detail
+
+// Checks that `json` is a single well-formed JSON value, including its
+// escape sequences, number grammar and UTF-8, without allocating. Much
+// cheaper than parse() or deserialize(), for rejecting bad input early.
+// Nesting is limited to `max_depth`, at most default_max_depth.
+inline validate_result validate(std::string_view json, std::size_t max_depth = default_max_depth) {
+    return detail::Validator(json, max_depth).run();
+}
+
+// Lazy, forward-only access to a few values of a large document, e.g.
+// `json_view doc(json); doc["user"]["id"].get<std::int64_t>()`. Lookups
+// walk the token index from the current position and skip every member or
+// element they pass by bracket counting; nothing is materialized. Values
+// must be visited in document order: once the view has moved past a value,
+// handles to it or to anything before it find nothing.
+class json_view {
+public:
+    class value {
+    public:
+        value() = default;
+
+        // Member `key` of this object, or an invalid value.
+        value operator[](std::string_view key) const { return view ? view->find(*this, key) : value{}; }
+        // Element `i` of this array, or an invalid value.
+        value operator[](std::size_t i) const { return view ? view->find(*this, i) : value{}; }
+
+        explicit operator bool() const { return view != nullptr; }
+        bool is_null() const { return view && view->at(*this) && view->tokenizer.token == detail::Token::NULL_TOKEN; }
+
+        // Deserializes this value into `out` with the typed deserializer, so
+        // objects skip unknown keys the same way. Returns the deserialize()
+        // error codes, or 1 if the value is invalid or was already passed.
+        // A get() that fails before consuming anything, e.g. on a value of
+        // another type, can be retried with another type.
+        template <typename T>
+        int get(T& out) const { return view ? view->read(*this, out) : 1; }
+
+        // As above, returning a value-initialized T on error.
+        template <typename T>
+        T get() const {
+            T out{};
+            return get(out) == 0 ? out : T{};
+        }
+
+    private:
+        json_view* view = nullptr;
+        std::size_t start = 0ul;
+        std::size_t depth = 0ul;
+
+        value(json_view* view, std::size_t start, std::size_t depth) : view(view), start(start), depth(depth) { }
+        friend class json_view;
+    };
+
+    explicit json_view(std::string_view json,
+                       std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : tokenizer(json, std::pmr::vector<std::uint32_t>(resource)), open(resource) {
+        if (json.size() > max_input_size) { err = 8; }
+        tokenizer.next();
+    }
+
+    // As above, with the index allocated from `opts.resource`, escaped
+    // strings read as std::string_view decoded into `opts.string_arena` and
+    // get() limited to `opts.max_depth`.
+    json_view(std::string_view json, const options& opts) : json_view(json, opts.resource) {
+        tokenizer.string_arena = opts.string_arena;
+        tokenizer.max_depth = opts.max_depth;
+    }
+
+    json_view(const json_view&) = delete;
+    json_view& operator=(const json_view&) = delete;
+
+    value root() { return {this, 0, 0}; }
+    value operator[](std::string_view key) { return root()[key]; }
+    value operator[](std::size_t i) { return root()[i]; }
+
+    // 0, or 1 once a lookup ran into malformed input or a get() failed part
+    // way through an object or array; later lookups find nothing. 7 if a
+    // skipped value nests too deep and 8 if the input is larger than
+    // max_input_size.
+    int error() const { return err; }
+
+private:
+    struct container {
+        std::size_t start;
+        std::size_t element;  // array elements handed out so far
+    };
+
+    detail::Tokenizer tokenizer;
+    std::pmr::vector<container> open;  // containers the tokenizer is inside
+    bool at_value = true;              // on the first token of a handed-out value
+    int err = 0;
+
+    value fail() {
+        err = 1;
+        return {};
+    }
+
+    // Whether the tokenizer is on the first token of `v`.
+    bool at(const value& v) const {
+        return at_value && tokenizer.position() == v.start && open.size() == v.depth;
+    }
+
+    bool inside(const value& v) const {
+        return open.size() > v.depth && open[v.depth].start == v.start;
+    }
+
+    // Enters `v` if it is the current value and a container of type `token`,
+    // or moves back up to the boundary between its members or elements if
+    // the tokenizer is somewhere inside it. A value of another type or one
+    // already passed is not an error; the lookup just finds nothing.
+    bool enter(const value& v, detail::Token token) {
+        if (err) { return false; }
+        if (at(v)) {
+            if (tokenizer.token != token) { return false; }
+            open.push_back({v.start, 0});
+            tokenizer.skip_to_next();
+            at_value = false;
+            return true;
+        }
+        if (!inside(v)) { return false; }
+        if (at_value) {
+            at_value = false;
+            if (detail::skip_value(tokenizer)) {
+                err = 1;
+                return false;
+            }
+        }
+        while (open.size() > v.depth + 1) {
+            if (int code = tokenizer.skip_past_close(tokenizer.sv[tokenizer.structurals()[open.back().start]])) {
+                err = code;
+                return false;
+            }
+            open.pop_back();
+        }
+        return true;
+    }
+
+    value find(const value& object, std::string_view key) {
+        bool first = at(object);
+        if (!enter(object, detail::Token::CURLY_OPEN)) { return {}; }
+        while (true) {
+            if (tokenizer.token == detail::Token::CURLY_CLOSE) {
+                tokenizer.skip_to_next();
+                open.pop_back();
+                return {};
+            }
+            if (!first) {
+                if (tokenizer.token != detail::Token::COMMA) { return fail(); }
+                tokenizer.skip_to_next();
+            }
+            first = false;
+            if (tokenizer.token != detail::Token::STRING) { return fail(); }
+            std::string_view name = tokenizer.get_sv();
+            tokenizer.next();
+            if (tokenizer.token != detail::Token::COLON || detail::has_control(name)) { return fail(); }
+            tokenizer.skip_to_next();
+            if (name == key) {
+                at_value = true;
+                return {this, tokenizer.position(), open.size()};
+            }
+            if (detail::skip_value(tokenizer)) { return fail(); }
+        }
+    }
+
+    value find(const value& array, std::size_t i) {
+        bool fresh = at(array);
+        if (!enter(array, detail::Token::SQUARE_OPEN)) { return {}; }
+        container& current = open.back();
+        if (!fresh && i < current.element) { return {}; }
+        for (std::size_t skipped = fresh ? 0 : current.element; ; ++skipped) {
+            if (tokenizer.token == detail::Token::SQUARE_CLOSE) {
+                tokenizer.skip_to_next();
+                open.pop_back();
+                return {};
+            }
+            if (skipped > 0) {
+                if (tokenizer.token != detail::Token::COMMA) { return fail(); }
+                tokenizer.skip_to_next();
+            }
+            if (skipped == i) {
+                current.element = i + 1;
+                at_value = true;
+                return {this, tokenizer.position(), open.size()};
+            }
+            if (detail::skip_value(tokenizer)) { return fail(); }
+        }
+    }
+
+    // A failed read that consumed nothing leaves the value to be read again;
+    // one that stopped inside an object or array leaves the tokenizer
+    // nowhere a lookup can resume from.
+    template <typename T>
+    int read(const value& v, T& out) {
+        if (err || !at(v)) { return 1; }
+        bool container = tokenizer.token == detail::Token::CURLY_OPEN || tokenizer.token == detail::Token::SQUARE_OPEN;
+        int result = detail::deserializer_impl<T>::deserialize(out, tokenizer);
+        if (result && tokenizer.position() == v.start) { return result; }
+        at_value = false;
+        if (result && container) { err = 1; }
+        return result;
+    }
+};
+
+// Read-only memory mapping of a whole file. The tokenizer never reads past
+// the end of its input (the last partial block is copied before it is
+// classified), so the mapping needs no padding after the page tail.
+class mapped_file {
+public:
+    mapped_file() = default;
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file(mapped_file&& other) noexcept
+        : address(std::exchange(other.address, nullptr)), length(std::exchange(other.length, 0)) { }
+    mapped_file& operator=(mapped_file&& other) noexcept {
+        if (this != &other) {
+            close();
+            address = std::exchange(other.address, nullptr);
+            length = std::exchange(other.length, 0);
+        }
+        return *this;
+    }
+    ~mapped_file() { close(); }
+
+    // Returns 0 on success and 5 if the file cannot be opened or mapped.
+    int open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) { return 5; }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            return 5;
+        }
+        std::size_t size = static_cast<std::size_t>(info.st_size);
+        if (size > 0) {
+            void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                return 5;
+            }
+            ::madvise(mapped, size, MADV_SEQUENTIAL);
+            address = mapped;
+            length = size;
+        }
+        ::close(fd);
+        return 0;
+    }
+
+    void close() {
+        if (address) { ::munmap(address, length); }
+        address = nullptr;
+        length = 0;
+    }
+
+    std::string_view view() const { return {static_cast<const char*>(address), length}; }
+
+private:
+    void* address = nullptr;
+    std::size_t length = 0ul;
+};
+
+// Deserializes the file at `path` in place from a read-only mapping kept in
+// `mapping`; std::string_view fields point into it and stay valid for as
+// long as `mapping` is open.
+template <typename To>
+int deserialize_file(To& to, const std::string& path, mapped_file& mapping) {
+    if (int err = mapping.open(path)) { return err; }
+    return deserialize(to, mapping.view());
+}
+
+namespace detail {
+
+// Whether deserializing into T can leave views into the input behind:
+// std::string_view and raw_json anywhere in it. `Outer` are the types
+// being checked around T, so recursive types terminate.
+template <typename T, typename... Outer>
+constexpr bool views_input() {
+    if constexpr ((std::same_as<T, Outer> || ...)) {
+        return false;
+    } else if constexpr (std::same_as<T, std::string_view> || std::same_as<T, raw_json>) {
+        return true;
+    } else if constexpr (numeric<T> || any_string<T>) {
+        return false;
+    } else if constexpr (is_optional<T>::value) {
+        return views_input<typename T::value_type, T, Outer...>();
+    } else if constexpr (string_keyed_map<T>) {
+        return views_input<typename T::key_type, T, Outer...>() || views_input<typename T::mapped_type, T, Outer...>();
+    } else if constexpr (sized_forward_range<T>) {
+        return views_input<std::remove_cv_t<std::ranges::range_value_t<T>>, T, Outer...>();
+    } else if constexpr (std::is_aggregate_v<T>) {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return (views_input<std::remove_cvref_t<decltype(reflect::get<I>(std::declval<T&>()))>, T, Outer...>() || ...);
+        }(std::make_index_sequence<reflect::size<T>()>{});
+    } else {
+        return false;
+    }
+}
+} // namespace detail
+
+// As above, but unmaps the file before returning, so `To` must not hold
+// views into the input.
+template <typename To>
+int deserialize_file(To& to, const std::string& path) {
+    static_assert(!detail::views_input<To>(),
+                  "To holds std::string_view or raw_json members, which would point into the unmapped file; "
+                  "pass a mapped_file that outlives them");
+    mapped_file mapping;
+    return deserialize_file(to, path, mapping);
+}
+
+enum class NodeType : char {
+    NONE = 0,
+    OBJECT = '{',
+    OBJECT_END = '}',
+    ARRAY = '[',
+    ARRAY_END = ']',
+    STRING = '"',
+    INT = 'l',
+    FLOAT = 'd',
+    TRUE_VALUE = 't',
+    FALSE_VALUE = 'f',
+    NULL_VALUE = 'n'
+};
+
+namespace detail {
+
+// A tape entry keeps the node type in the top byte and a 56-bit payload:
+//   OBJECT/ARRAY   element count << 32 | index of the entry after the matching end
+//   OBJECT_END/ARRAY_END   offset into the input of the opening bracket
+//   STRING         offset into the input, followed by a word with the length;
+//                  if the string had escapes, the top bit of that word is set
+//                  and the decoded bytes follow in the next words instead
+//   INT/FLOAT      offset into the input, followed by a word with the
+//                  int64/double bits
+//   TRUE/FALSE/NULL_VALUE   offset into the input
+// Input offsets are 0 for documents built by a push_parser.
+using Tape = std::pmr::vector<std::uint64_t>;
+
+inline constexpr std::uint64_t tape_payload_mask = (std::uint64_t{1} << 56) - 1;
+inline constexpr std::uint64_t tape_max_count = 0xffffff;
+inline constexpr std::uint64_t tape_decoded_bit = std::uint64_t{1} << 63;
+
+inline constexpr std::uint64_t tape_entry(NodeType type, std::uint64_t payload = 0) {
+    return std::uint64_t{static_cast<unsigned char>(type)} << 56 | payload;
+}
+
+inline constexpr NodeType tape_type(std::uint64_t entry) {
+    return static_cast<NodeType>(static_cast<char>(entry >> 56));
+}
+
+inline constexpr std::uint64_t tape_payload(std::uint64_t entry) {
+    return entry & tape_payload_mask;
+}
+
+// Length of the well-formed JSON value at input[start], found by matching
+// quotes and brackets.
+inline std::size_t value_length(std::string_view input, std::size_t start) {
+    std::size_t i = start;
+    std::size_t depth = 0ul;
+    do {
+        char c = input[i];
+        if (c == '"') {
+            for (++i; input[i] != '"'; ++i) {
+                if (input[i] == '\\') { ++i; }
+            }
+            ++i;
+        } else if (c == '{' || c == '[') {
+            ++depth;
+            ++i;
+        } else if (c == '}' || c == ']') {
+            --depth;
+            ++i;
+        } else if (depth == 0) {
+            while (i < input.size() && !ends_literal(input[i])) { ++i; }
+        } else {
+            ++i;
+        }
+    } while (depth > 0 && i < input.size());
+    return i - start;
+}
+
+inline std::size_t tape_next(const Tape& tape, std::size_t pos) {
+    switch (tape_type(tape[pos])) {
+        case NodeType::OBJECT:
+        case NodeType::ARRAY:
+            return tape_payload(tape[pos]) & 0xffffffff;
+        case NodeType::STRING:
+            if (tape[pos + 1] & tape_decoded_bit) {
+                return pos + 2 + ((tape[pos + 1] & ~tape_decoded_bit) + 7) / 8;
+            }
+            return pos + 2;
+        case NodeType::INT:
+        case NodeType::FLOAT:
+            return pos + 2;
+        default:
+            return pos + 1;
+    }
+}
+
+// An object or array whose entries are still being written to the tape.
+struct open_container {
+    std::size_t open;  // tape position of its start entry
+    std::uint64_t count;
+    bool object;
+};
+} // namespace detail
+
+class Document;
+
+namespace detail {
+
+inline int parse_document(std::string_view json, Document& doc, std::size_t max_depth, stats* sink);
+} // namespace detail
+
+// Read-only view of one value on a Document's tape. A default-constructed
+// Element stands for a missing value.
+class Element {
+public:
+    Element() = default;
+    Element(const Document* document, std::size_t position) : doc(document), pos(position) { }
+
+    explicit operator bool() const { return doc != nullptr; }
+
+    inline NodeType type() const;
+
+    bool is_object() const { return type() == NodeType::OBJECT; }
+    bool is_array() const { return type() == NodeType::ARRAY; }
+    bool is_string() const { return type() == NodeType::STRING; }
+    bool is_int() const { return type() == NodeType::INT; }
+    bool is_float() const { return type() == NodeType::FLOAT; }
+    bool is_number() const { return is_int() || is_float(); }
+    bool is_bool() const { return type() == NodeType::TRUE_VALUE || type() == NodeType::FALSE_VALUE; }
+    bool is_null() const { return type() == NodeType::NULL_VALUE; }
+
+    // The value of a string, integer, number or bool; a missing Element or
+    // one of another type gives "", 0, 0.0 or false.
+    inline std::string_view get_string() const;
+    inline std::int64_t get_int() const;
+    inline double get_float() const;
+    bool get_bool() const { return type() == NodeType::TRUE_VALUE; }
+
+    // Number of elements or members of an array or object.
+    inline std::size_t size() const;
+
+    // The text of this value in the parsed input, or empty if the Document
+    // was built by a push_parser and has no input.
+    inline std::string_view json() const;
+
+    // Member lookup by key; returns a missing Element if there is none.
+    inline Element operator[](std::string_view key) const;
+
+#ifdef DEBUG
+    std::string class_name() const {
+        switch (type()) {
+            case NodeType::OBJECT: return "Members";
+            case NodeType::ARRAY: return "Array";
+            case NodeType::STRING: return "String";
+            case NodeType::INT:
+            case NodeType::FLOAT: return "Number";
+            case NodeType::TRUE_VALUE:
+            case NodeType::FALSE_VALUE: return "Bool";
+            case NodeType::NULL_VALUE: return "Null";
+            default: return "None";
+        }
+    }
+#endif
+
+    // Iterates the elements of an array, or the values of an object. For
+    // objects the position is that of the key.
+    class iterator {
+    public:
+        iterator(const Document* document, std::size_t position, bool members)
+            : doc(document), pos(position), object(members) { }
+        inline Element operator*() const;
+        inline iterator& operator++();
+        bool operator==(const iterator& other) const { return pos == other.pos; }
+        std::string_view key() const { return Element{doc, pos}.get_string(); }
+    private:
+        const Document* doc;
+        std::size_t pos;
+        bool object;
+    };
+
+    inline iterator begin() const;
+    inline iterator end() const;
+
+private:
+    const Document* doc = nullptr;
+    std::size_t pos = 0ul;
+
+    inline std::uint64_t word(std::size_t offset) const;
+};
+
+// Owns the tape of a parsed document together with the scratch index used
+// to build it. Both keep their capacity across reset(), so parsing into a
+// reused Document allocates nothing once it has seen a document as large.
+// Both are allocated from the resource given at construction; the Document
+// counts those allocations, so it cannot be moved.
+// Strings without escapes point into the parsed input, which must outlive
+// the tape; escaped ones are decoded onto the tape.
+class Document {
+public:
+    explicit Document(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : counter(resource), tape(&counter), index(&counter), stack(&counter) { }
+
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    Element root() const { return tape.empty() ? Element{} : Element{this, 0}; }
+
+    void reset() {
+        tape.clear();
+        input = {};
+        mapping.close();
+    }
+
+    std::size_t tape_size() const { return tape.size(); }
+
+private:
+    detail::CountingResource counter;
+    detail::Tape tape;
+    std::pmr::vector<std::uint32_t> index;
+    std::pmr::vector<detail::open_container> stack;  // used while parsing
+    std::string_view input;
+    mapped_file mapping;
+
+    friend class Element;
+    friend int detail::parse_document(std::string_view json, Document& doc, std::size_t max_depth, stats* sink);
+    friend int parse_file(const std::string& path, Document& doc);
+    friend class push_parser;
+};
+
+inline NodeType Element::type() const {
+    return doc ? detail::tape_type(doc->tape[pos]) : NodeType::NONE;
+}
+
+inline std::uint64_t Element::word(std::size_t offset) const { return doc->tape[pos + offset]; }
+
+inline std::string_view Element::get_string() const {
+    if (!is_string()) { return {}; }
+    std::uint64_t length = word(1);
+    if (length & detail::tape_decoded_bit) {
+        return {reinterpret_cast<const char*>(&doc->tape[pos + 2]), length & ~detail::tape_decoded_bit};
+    }
+    return doc->input.substr(detail::tape_payload(word(0)), length);
+}
+
+inline std::string_view Element::json() const {
+    if (!doc || doc->input.empty()) { return {}; }
+    std::uint64_t start;
+    switch (type()) {
+        case NodeType::OBJECT:
+        case NodeType::ARRAY:
+            start = detail::tape_payload(doc->tape[(detail::tape_payload(word(0)) & 0xffffffff) - 1]);
+            break;
+        case NodeType::STRING:
+            start = detail::tape_payload(word(0)) - 1;
+            break;
+        default:
+            start = detail::tape_payload(word(0));
+    }
+    return doc->input.substr(start, detail::value_length(doc->input, start));
+}
+
+inline std::int64_t Element::get_int() const {
+    return is_int() ? static_cast<std::int64_t>(word(1)) : 0;
+}
+
+inline double Element::get_float() const {
+    if (is_int()) { return static_cast<double>(get_int()); }
+    return is_float() ? std::bit_cast<double>(word(1)) : 0.0;
+}
+
+inline std::size_t Element::size() const {
+    if (!is_object() && !is_array()) { return 0; }
+    std::size_t count = detail::tape_payload(word(0)) >> 32;
+    if (count < detail::tape_max_count) { return count; }
+    count = 0;
+    for (auto it = begin(); it != end(); ++it) { ++count; }
+    return count;
+}
+
+inline Element Element::operator[](std::string_view key) const {
+    if (!is_object()) { return {}; }
+    for (auto it = begin(); it != end(); ++it) {
+        if (it.key() == key) { return *it; }
+    }
+    return {};
+}
+
+inline Element::iterator Element::begin() const {
+    if (!is_object() && !is_array()) { return end(); }
+    bool empty = detail::tape_type(word(1)) == NodeType::OBJECT_END ||
+                 detail::tape_type(word(1)) == NodeType::ARRAY_END;
+    if (empty) { return end(); }
+    return {doc, pos + 1, is_object()};
+}
+
+inline Element::iterator Element::end() const {
+    if (!is_object() && !is_array()) { return {doc, pos, false}; }
+    return {doc, (detail::tape_payload(word(0)) & 0xffffffff) - 1, is_object()};
+}
+
+inline Element Element::iterator::operator*() const {
+    return {doc, object ? detail::tape_next(doc->tape, pos) : pos};
+}
+
+inline Element::iterator& Element::iterator::operator++() {
+    if (object) { pos = detail::tape_next(doc->tape, pos); }
+    pos = detail::tape_next(doc->tape, pos);
+    return *this;
+}
+
+namespace detail {
+
+// Until it is closed, the start entry of a container holds the input
+// offset of its opening bracket, which moves to the end entry.
+inline void close_container(Tape& tape, std::size_t open, NodeType type, std::uint64_t count) {
+    tape.push_back(tape_entry(type == NodeType::OBJECT ? NodeType::OBJECT_END : NodeType::ARRAY_END, tape[open]));
+    tape[open] = tape_entry(type, std::min(count, tape_max_count) << 32 | tape.size());
+}
+
+// Writes the flagged length word and the decoded bytes of a string token
+// after its STRING entry.
+inline bool push_decoded_string(Tape& tape, std::string_view raw, std::size_t first_escape) {
+    std::size_t length_pos = tape.size();
+    tape.resize(length_pos + 1 + (raw.size() + 7) / 8);
+    char* decoded = reinterpret_cast<char*>(&tape[length_pos + 1]);
+    char* end = unescape(raw, first_escape, decoded);
+    if (!end) { return false; }
+    auto length = static_cast<std::uint64_t>(end - decoded);
+    tape[length_pos] = length | tape_decoded_bit;
+    tape.resize(length_pos + 1 + (length + 7) / 8);
+    return true;
+}
+
+// Integers that do not fit int64 are kept as doubles.
+inline bool push_number(Tape& tape, std::string_view number, Token kind, std::uint64_t offset) {
+    std::int64_t integer = 0;
+    double real = 0.0;
+    if (kind == Token::NUMBER_INT && parse_number(number, integer) == std::errc{}) {
+        tape.push_back(tape_entry(NodeType::INT, offset));
+        tape.push_back(static_cast<std::uint64_t>(integer));
+    } else if (parse_number(number, real) == std::errc{}) {
+        tape.push_back(tape_entry(NodeType::FLOAT, offset));
+        tape.push_back(std::bit_cast<std::uint64_t>(real));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline bool parse_string(Tokenizer* tokenizer, Tape& tape) {
+    if (tokenizer->token != Token::STRING) { return false; }
+    std::string_view str = tokenizer->get_sv();
+    tokenizer->next();
+    tape.push_back(tape_entry(NodeType::STRING, static_cast<std::uint64_t>(str.data() - tokenizer->sv.data())));
+    std::size_t escape = find_escape(str.data(), str.size());
+    if (escape == str.size()) {
+        tape.push_back(str.size());
+        return true;
+    }
+    return push_decoded_string(tape, str, escape);
+}
+
+// Appends a string, number or literal value and moves past it.
+inline bool parse_scalar(Tokenizer* tokenizer, Tape& tape) {
+    if (tokenizer->token == Token::STRING) {
+        return parse_string(tokenizer, tape);
+    }
+    std::uint64_t offset = tokenizer->offset();
+    if (tokenizer->token == Token::NUMBER_INT || tokenizer->token == Token::NUMBER_FLOAT) {
+        Token kind = tokenizer->token;
+        if (!push_number(tape, tokenizer->get_sv(), kind, offset)) { return false; }
+    } else if (tokenizer->token == Token::BOOL_TRUE) {
+        tape.push_back(tape_entry(NodeType::TRUE_VALUE, offset));
+        tokenizer->skip();
+    } else if (tokenizer->token == Token::BOOL_FALSE) {
+        tape.push_back(tape_entry(NodeType::FALSE_VALUE, offset));
+        tokenizer->skip();
+    } else if (tokenizer->token == Token::NULL_TOKEN) {
+        tape.push_back(tape_entry(NodeType::NULL_VALUE, offset));
+        tokenizer->skip();
+    } else {
+        return false;
+    }
+    tokenizer->next();
+    return true;
+}
+
+// Appends an object key and moves past the colon after it.
+inline bool parse_key(Tokenizer* tokenizer, Tape& tape) {
+    if (!parse_string(tokenizer, tape) || tokenizer->token != Token::COLON) { return false; }
+    tokenizer->skip_to_next();
+    return true;
+}
+
+// Builds the tape of the value at the current token in one loop. The
+// containers being filled are kept on `stack`, whose capacity the Document
+// reuses, instead of on the call stack, so nesting costs one entry per
+// level. Returns 0, 1 for malformed input or 7 if the value nests deeper
+// than `max_depth`.
+inline int parse_value(Tokenizer* tokenizer, Tape& tape, std::pmr::vector<open_container>& stack,
+                       std::size_t max_depth) {
+    stack.clear();
+    while (true) {
+        bool closing = false;
+        if (tokenizer->token == Token::CURLY_OPEN || tokenizer->token == Token::SQUARE_OPEN) {
+            if (stack.size() == max_depth) { return 7; }
+            bool object = tokenizer->token == Token::CURLY_OPEN;
+            stack.push_back({tape.size(), 0, object});
+            tape.push_back(tokenizer->offset());
+            tokenizer->skip_to_next();
+            closing = tokenizer->token == (object ? Token::CURLY_CLOSE : Token::SQUARE_CLOSE);
+            if (!closing) {
+                if (object && !parse_key(tokenizer, tape)) { return 1; }
+                continue;
+            }
+        } else if (!parse_scalar(tokenizer, tape)) {
+            return 1;
+        }
+        // A value has ended: close the containers that end with it, then
+        // move to the next member or element.
+        while (true) {
+            if (closing) {
+                open_container top = stack.back();
+                stack.pop_back();
+                tokenizer->skip_to_next();
+                close_container(tape, top.open, top.object ? NodeType::OBJECT : NodeType::ARRAY, top.count);
+            }
+            if (stack.empty()) { return 0; }
+            open_container& top = stack.back();
+            ++top.count;
+            if (tokenizer->token == Token::COMMA) {
+                tokenizer->skip_to_next();
+                if (top.object && !parse_key(tokenizer, tape)) { return 1; }
+                break;
+            }
+            closing = tokenizer->token == (top.object ? Token::CURLY_CLOSE : Token::SQUARE_CLOSE);
+            if (!closing) { return 1; }
+        }
+    }
+}
+} // namespace detail
+
+// Parses `json` onto the tape of `doc`, replacing its previous contents.
+// Returns the same error codes as deserialize().
+inline int parse(std::string_view json, Document& doc) {
+    return detail::parse_document(json, doc, default_max_depth, nullptr);
+}
+
+// As above, with nesting limited to `opts.max_depth` and the call measured
+// into `opts.sink` when one is given. The tape and index come from the
+// resource `doc` was constructed with, so `opts.resource` is not used.
+inline int parse(std::string_view json, Document& doc, const options& opts) {
+    return detail::parse_document(json, doc, opts.max_depth, opts.sink);
+}
+
+namespace detail {
+
+inline int parse_document(std::string_view json, Document& doc, std::size_t max_depth, stats* sink) {
+    std::size_t allocations = doc.counter.allocations;
+    std::size_t allocated_bytes = doc.counter.allocated_bytes;
+    doc.reset();
+    if (json.size() > max_input_size) { return 8; }
+    doc.input = json;
+    Stopwatch watch(sink);
+    Tokenizer tokenizer(json, std::move(doc.index));
+    watch.lap(&stats::tokenize_time);
+    tokenizer.next();
+    int err = parse_value(&tokenizer, doc.tape, doc.stack, max_depth);
+    bool at_end = tokenizer.is_end();
+    watch.lap(&stats::build_time);
+    if (sink) {
+        record_input(*sink, tokenizer);
+        sink->allocations += doc.counter.allocations - allocations;
+        sink->allocated_bytes += doc.counter.allocated_bytes - allocated_bytes;
+    }
+    doc.index = tokenizer.release_index();
+    if (err) {
+        doc.tape.clear();
+        return err;
+    }
+    return at_end ? 0 : 2;
+}
+} // namespace detail
+
+// Parses the file at `path` from a read-only mapping owned by `doc`, which
+// keeps it alive until the next reset() or parse.
+inline int parse_file(const std::string& path, Document& doc) {
+    mapped_file mapping;
+    if (int err = mapping.open(path)) { return err; }
+    int err = parse(mapping.view(), doc);
+    doc.mapping = std::move(mapping);
+    return err;
+}
+
+// Parses one JSON document onto the tape of a Document from chunks of any
+// size, e.g. socket reads, without keeping the input: tokens split across
+// chunks are carried over, strings are copied onto the tape, and open
+// containers are tracked on an explicit stack, so memory is the tape plus
+// the longest string or number.
+class push_parser {
+public:
+    explicit push_parser(Document& document, std::size_t max_depth = default_max_depth)
+        : doc(&document), pending(&document.counter), stack(&document.counter), max_depth(max_depth) {
+        doc->reset();
+    }
+
+    push_parser(const push_parser&) = delete;
+    push_parser& operator=(const push_parser&) = delete;
+
+    // Consumes `chunk`. Returns 0 while the input is a valid prefix of a
+    // document, 1 once it is malformed, 2 if anything but whitespace
+    // follows the value and 7 if it nests deeper than max_depth; errors
+    // are sticky.
+    int feed(std::span<const char> chunk) {
+        const char* data = chunk.data();
+        std::size_t size = chunk.size();
+        std::size_t i = 0ul;
+        while (i < size && !err) {
+            switch (state) {
+                case State::STRING:
+                    i = scan_string(data, size, i);
+                    break;
+                case State::LITERAL:
+                    while (i < size && !detail::ends_literal(data[i])) { pending.push_back(data[i++]); }
+                    if (i < size) { end_literal(); }
+                    break;
+                default:
+                    if (detail::is_whitespace(data[i])) {
+                        ++i;
+                    } else {
+                        structural(data[i]);
+                        // A literal's first byte is left for the LITERAL state.
+                        if (state != State::LITERAL) { ++i; }
+                    }
+            }
+        }
+        return err;
+    }
+
+    // Ends the input. Returns 0 if it held exactly one complete value and
+    // the feed() error codes otherwise; the Document is cleared on error.
+    int finish() {
+        if (!err && state == State::LITERAL) { end_literal(); }
+        if (!err && state != State::DONE) { err = 1; }
+        if (err) { doc->tape.clear(); }
+        return err;
+    }
+
+private:
+    enum class State : char {
+        VALUE,
+        FIRST_VALUE_OR_END,  // after '['
+        FIRST_KEY_OR_END,    // after '{'
+        KEY,                 // after ',' in an object
+        COLON,
+        AFTER_VALUE,
+        STRING,
+        LITERAL,
+        DONE
+    };
+
+    Document* doc;
+    std::pmr::string pending;  // bytes of the string or literal being read
+    std::pmr::vector<detail::open_container> stack;
+    std::size_t max_depth;
+    State state = State::VALUE;
+    bool key = false;      // the string being read is an object key
+    bool escaped = false;  // the chunk ended right after a backslash
+    int err = 0;
+
+    void structural(char c) {
+        switch (state) {
+            case State::FIRST_VALUE_OR_END:
+                if (c == ']') { return close(false); }
+                [[fallthrough]];
+            case State::VALUE:
+                return begin_value(c);
+            case State::FIRST_KEY_OR_END:
+                if (c == '}') { return close(true); }
+                [[fallthrough]];
+            case State::KEY:
+                if (c != '"') { return fail(); }
+                key = true;
+                pending.clear();
+                state = State::STRING;
+                return;
+            case State::COLON:
+                if (c != ':') { return fail(); }
+                state = State::VALUE;
+                return;
+            case State::AFTER_VALUE:
+                if (c == ',') {
+                    state = stack.back().object ? State::KEY : State::VALUE;
+                } else if (c == '}' || c == ']') {
+                    if (stack.back().object != (c == '}')) { return fail(); }
+                    close(c == '}');
+                } else {
+                    fail();
+                }
+                return;
+            default:
+                err = 2;
+        }
+    }
+
+    void begin_value(char c) {
+        switch (c) {
+            case '{':
+            case '[':
+                if (stack.size() == max_depth) {
+                    err = 7;
+                    return;
+                }
+                stack.push_back({doc->tape.size(), 0, c == '{'});
+                doc->tape.push_back(0);
+                state = c == '{' ? State::FIRST_KEY_OR_END : State::FIRST_VALUE_OR_END;
+                return;
+            case '"':
+                key = false;
+                pending.clear();
+                state = State::STRING;
+                return;
+            case '}': case ']': case ':': case ',':
+                return fail();
+            default:
+                pending.clear();
+                state = State::LITERAL;
+        }
+    }
+
+    void close(bool object) {
+        detail::open_container top = stack.back();
+        stack.pop_back();
+        detail::close_container(doc->tape, top.open, object ? NodeType::OBJECT : NodeType::ARRAY, top.count);
+        end_value();
+    }
+
+    void end_value() {
+        if (stack.empty()) {
+            state = State::DONE;
+        } else {
+            ++stack.back().count;
+            state = State::AFTER_VALUE;
+        }
+    }
+
+    // Copies string bytes up to the closing quote, a run at a time.
+    std::size_t scan_string(const char* data, std::size_t size, std::size_t i) {
+        if (escaped) {
+            pending.push_back(data[i++]);
+            escaped = false;
+        }
+        while (i < size) {
+            std::size_t run = detail::find_escape(data + i, size - i);
+            pending.append(data + i, run);
+            i += run;
+            if (i == size) { break; }
+            char c = data[i++];
+            if (c == '"') {
+                end_string();
+                break;
+            }
+            if (c != '\\') {
+                fail();  // unescaped control character
+                break;
+            }
+            pending.push_back(c);
+            if (i == size) {
+                escaped = true;
+                break;
+            }
+            pending.push_back(data[i++]);
+        }
+        return i;
+    }
+
+    void end_string() {
+        auto& tape = doc->tape;
+        tape.push_back(detail::tape_entry(NodeType::STRING));
+        if (!detail::push_decoded_string(tape, pending, detail::find_escape(pending.data(), pending.size()))) {
+            return fail();
+        }
+        if (key) {
+            state = State::COLON;
+        } else {
+            end_value();
+        }
+    }
+
+    void end_literal() {
+        auto& tape = doc->tape;
+        std::string_view literal = pending;
+        if (literal == "null") {
+            tape.push_back(detail::tape_entry(NodeType::NULL_VALUE));
+        } else if (literal == "true") {
+            tape.push_back(detail::tape_entry(NodeType::TRUE_VALUE));
+        } else if (literal == "false") {
+            tape.push_back(detail::tape_entry(NodeType::FALSE_VALUE));
+        } else {
+            detail::Token kind = detail::classify_number(literal);
+            if (kind == detail::Token::INVALID || !detail::push_number(tape, literal, kind, 0)) { return fail(); }
+        }
+        end_value();
+    }
+
+    void fail() { err = 1; }
+};
+
+namespace detail {
+
+// Binds a parsed Document to a typed value, following the same rules as
+// deserializer_impl.
+template <typename To>
+struct element_binder {
+    static int bind(To& obj, const Element& element) {
+        if (!element.is_object()) { return 1; }
+        std::size_t expected = 0ul;
+        for (auto it = element.begin(); it != element.end(); ++it) {
+            std::size_t index = member_index<To>::find(it.key(), expected);
+            if (index >= member_index<To>::count) { continue; }
+            if (int err = binders[index](obj, *it)) { return err; }
+            expected = index + 1;
+        }
+        return 0;
+    }
+
+private:
+    template <std::size_t I>
+    static int bind_member(To& obj, const Element& element) {
+        auto& ith_member = reflect::get<I>(obj);
+        using member_t = std::remove_cvref_t<decltype(ith_member)>;
+        return element_binder<member_t>::bind(ith_member, element);
+    }
+
+    using member_binder = int (*)(To&, const Element&);
+
+    static constexpr auto binders = []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<member_binder, sizeof...(I)>{&bind_member<I>...};
+    }(std::make_index_sequence<member_index<To>::count>{});
+};
+
+template <sized_forward_range To>
+struct element_binder<To> {
+    static int bind(To& obj, const Element& element) {
+        using value_t = std::ranges::range_value_t<To>;
+        if (!element.is_array()) { return 1; }
+        auto it = std::ranges::begin(obj);
+        auto end = std::ranges::end(obj);
+        for (Element value : element) {
+            if (it == end) { return 1; }
+            if (int err = element_binder<value_t>::bind(*it, value)) { return err; }
+            ++it;
+        }
+        return 0;
+    }
+};
+
+template <resizable_range To>
+struct element_binder<To> {
+    static int bind(To& obj, const Element& element) {
+        using value_t = std::ranges::range_value_t<To>;
+        if (!element.is_array()) { return 1; }
+        std::size_t size = std::ranges::size(obj);
+        std::size_t count = 0ul;
+        auto it = std::ranges::begin(obj);
+        for (Element value : element) {
+            value_t& target = count < size ? *it++ : obj.emplace_back();
+            ++count;
+            if (int err = element_binder<value_t>::bind(target, value)) { return err; }
+        }
+        if (count < size) { obj.resize(count); }
+        return 0;
+    }
+};
+
+template <string_keyed_map To>
+struct element_binder<To> {
+    static int bind(To& obj, const Element& element) {
+        if (!element.is_object()) { return 1; }
+        MapFiller<To> filler(obj);
+        for (auto it = element.begin(); it != element.end(); ++it) {
+            if (int err = element_binder<typename To::mapped_type>::bind(filler.slot(it.key()), *it)) { return err; }
+        }
+        filler.finish();
+        return 0;
+    }
+};
+
+// Integers beyond int64 are doubles on the tape, so they only bind to
+// floating-point fields.
+template <numeric_except_bool To>
+struct element_binder<To> {
+    static int bind(To& obj, const Element& element) {
+        if (element.is_int()) {
+            std::int64_t value = element.get_int();
+            if constexpr (std::is_integral_v<To> && std::is_signed_v<To>) {
+                if (value < std::numeric_limits<To>::min() || value > std::numeric_limits<To>::max()) { return 3; }
+            } else if constexpr (std::is_integral_v<To>) {
+                if (value < 0 || static_cast<std::uint64_t>(value) > std::numeric_limits<To>::max()) { return 3; }
+            }
+            obj = static_cast<To>(value);
+            return 0;
+        }
+        if constexpr (std::floating_point<To>) {
+            if (element.type() != NodeType::FLOAT) { return 1; }
+            double value = element.get_float();
+            if (std::abs(value) > static_cast<double>(std::numeric_limits<To>::max())) { return 3; }
+            obj = static_cast<To>(value);
+            return 0;
+        } else {
+            return 1;
+        }
+    }
+};
+
+template <>
+struct element_binder<bool> {
+    static int bind(bool& obj, const Element& element) {
+        if (element.type() != NodeType::TRUE_VALUE && element.type() != NodeType::FALSE_VALUE) { return 1; }
+        obj = element.get_bool();
+        return 0;
+    }
+};
+
+template <any_string To>
+struct element_binder<To> {
+    static int bind(To& obj, const Element& element) {
+        if (!element.is_string()) { return 1; }
+        obj = element.get_string();
+        return 0;
+    }
+};
+
+// Views the text of the element in the Document's input, so a Document
+// built by push_parser, which keeps no input, gives error 1.
+template <>
+struct element_binder<raw_json> {
+    static int bind(raw_json& obj, const Element& element) {
+        std::string_view text = element.json();
+        if (text.empty()) { return 1; }
+        obj = raw_json{text};
+        return 0;
+    }
+};
+
+template <typename To>
+struct element_binder<std::optional<To>> {
+    static int bind(std::optional<To>& to, const Element& element) {
+        if (element.type() == NodeType::NULL_VALUE) {
+            to.reset();
+            return 0;
+        }
+        if (!to) { to.emplace(); }
+        return element_binder<To>::bind(*to, element);
+    }
+};
+} // namespace detail
+
+// Fills `to` from a parsed element, e.g. the root of a Document built by
+// push_parser, with the rules and error codes of deserialize(). String
+// fields of type std::string_view point into the Document.
+template <typename To>
+int deserialize(To& to, const Element& element) {
+    return detail::element_binder<To>::bind(to, element);
+}
+
+namespace detail {
+
+// Finds where top-level values end in a stream of newline-delimited or
+// concatenated JSON. The state survives between calls, so a record split
+// across reads is scanned only once.
+class RecordScanner {
+public:
+    // Scans data[from, size) and returns the offset one past the end of the
+    // current record, or npos if the record continues beyond `size`.
+    std::size_t scan(const char* data, std::size_t from, std::size_t size) {
+        for (std::size_t it = from; it < size; ++it) {
+            char c = data[it];
+            if (in_string) {
+                if (escaped) {
+                    escaped = false;
+                } else if (c == '\\') {
+                    escaped = true;
+                } else if (c == '"') {
+                    in_string = false;
+                    if (depth == 0) { return finish(it + 1); }
+                }
+            } else if (in_scalar) {
+                if (is_whitespace(c) || c == '{' || c == '[' || c == '"') {
+                    return finish(it);
+                }
+            } else if (c == '"') {
+                started = true;
+                in_string = true;
+            } else if (c == '{' || c == '[') {
+                started = true;
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                started = true;
+                if (depth <= 1) { return finish(it + 1); }
+                --depth;
+            } else if (!is_whitespace(c) && depth == 0) {
+                started = true;
+                in_scalar = true;
             }
-        } else {
-            token_end = match_quote();
-            token = Token::STRING;
-        } 
-        return;
+        }
+        return std::string_view::npos;
     }
 
+    // A scalar record may end at the end of the input.
+    bool pending_scalar() const { return in_scalar; }
+    bool started_record() const { return started; }
+
+    void reset() { *this = RecordScanner{}; }
+
 private:
-    std::size_t token_current=0ul;
-    std::size_t token_end=0ul;
+    std::size_t depth = 0ul;
+    bool in_string = false;
+    bool escaped = false;
+    bool in_scalar = false;
+    bool started = false;
+
+    std::size_t finish(std::size_t end) {
+        reset();
+        return end;
+    }
+};
+} // namespace detail
+
+// Reads a stream of newline-delimited or concatenated JSON values one record
+// at a time through a fixed-size buffer. Partial records are carried over to
+// the next read, so memory stays proportional to the buffer size; a single
+// record must fit in the buffer.
+template <typename T>
+class record_reader {
+public:
+    explicit record_reader(std::istream& in, std::size_t buffer_size = std::size_t{1} << 20)
+        : stream(&in), storage(std::make_unique_for_overwrite<char[]>(buffer_size)), capacity(buffer_size) { }
 
-    inline void skip_whitespaces() {
-        while (token_current < sv.length() && sv[token_current] == ' ')
-            ++token_current;
+    explicit record_reader(int fd, std::size_t buffer_size = std::size_t{1} << 20)
+        : fd(fd), storage(std::make_unique_for_overwrite<char[]>(buffer_size)), capacity(buffer_size) { }
+
+    // Deserializes the next record into `out`. Returns false at the end of
+    // the input or on error; error() tells them apart. A record that fails
+    // to deserialize is consumed, so reading can continue after it; so is a
+    // record cut off by the end of the input, which is error 1 once and then
+    // a clean end.
+    bool next(T& out) {
+        err = 0;
+        while (true) {
+            std::size_t end = scanner.scan(storage.get(), scanned, filled);
+            if (end != std::string_view::npos) {
+                return emit(out, end);
+            }
+            scanned = filled;
+            if (eof) {
+                bool scalar = scanner.pending_scalar();
+                bool truncated = scanner.started_record();
+                scanner.reset();
+                if (scalar) { return emit(out, filled); }
+                if (truncated) { err = 1; }
+                begin = scanned = filled;
+                return false;
+            }
+            if (!refill()) { return false; }
+        }
     }
 
-    inline void update_current_pos() {
-        if (token_end <= token_current) { token_end = token_current + 1; }
-        token_current = token_end; 
+    // 0 after a successful record or at a clean end of input, a deserialize()
+    // error code for a malformed record, 4 if a record does not fit in the
+    // buffer and 5 on a read error.
+    int error() const { return err; }
+
+private:
+    std::istream* stream = nullptr;
+    int fd = -1;
+    std::unique_ptr<char[]> storage;
+    std::size_t capacity;
+    std::size_t begin = 0ul;
+    std::size_t scanned = 0ul;
+    std::size_t filled = 0ul;
+    bool eof = false;
+    int err = 0;
+    detail::RecordScanner scanner;
+    std::pmr::vector<std::uint32_t> index;
+
+    bool emit(T& out, std::size_t end) {
+        std::string_view record{storage.get() + begin, end - begin};
+        begin = scanned = end;
+        detail::Tokenizer tokenizer(record, std::move(index));
+        err = detail::deserialize_document(out, tokenizer);
+        index = tokenizer.release_index();
+        return err == 0;
     }
 
-    inline std::size_t try_consume_expected(std::size_t s, std::string_view e) const {
-        if (token_current < (sv.length() - s) && sv.substr(token_current, s) == e) {
-            return token_current + s;
+    bool refill() {
+        if (begin > 0) {
+            std::memmove(storage.get(), storage.get() + begin, filled - begin);
+            filled -= begin;
+            scanned -= begin;
+            begin = 0;
+        }
+        if (filled == capacity) {
+            err = 4;
+            return false;
         }
-        return token_current;
+        std::size_t n = 0;
+        if (stream) {
+            stream->read(storage.get() + filled, static_cast<std::streamsize>(capacity - filled));
+            n = static_cast<std::size_t>(stream->gcount());
+            if (stream->bad()) { err = 5; return false; }
+        } else {
+            ssize_t got;
+            do {
+                got = ::read(fd, storage.get() + filled, capacity - filled);
+            } while (got < 0 && errno == EINTR);
+            if (got < 0) { err = 5; return false; }
+            n = static_cast<std::size_t>(got);
+        }
+        eof = n == 0;
+        filled += n;
+        return true;
     }
+};
+
+namespace detail {
+
+// Sink with two fixed-size buffers: while a background thread writes one
+// out, serialization fills the other. Memory stays at two buffers however
+// large the output is. A failed write sets error 5 and drops the rest.
+class DoubleBufferedSink {
+public:
+    DoubleBufferedSink(int fd, std::ostream* stream, std::size_t buffer_size)
+        : fd(fd), stream(stream), size(std::max(buffer_size, std::size_t{64})),
+          storage(std::make_unique_for_overwrite<char[]>(size * 2)), active(storage.get()),
+          writer([this] { run(); }) { }
 
-    inline std::size_t try_read_true() const { return try_consume_expected(4ul, "true"); }
+    DoubleBufferedSink(const DoubleBufferedSink&) = delete;
+    DoubleBufferedSink& operator=(const DoubleBufferedSink&) = delete;
+    ~DoubleBufferedSink() { finish(); }
 
-    inline std::size_t try_read_false() const { return try_consume_expected(5ul, "false"); }
+    inline void put(char c) {
+        if (length == size) [[unlikely]] { hand_off(); }
+        active[length++] = c;
+    }
 
-    inline std::size_t try_read_null() const { return try_consume_expected(4ul, "null"); }
+    inline void write(const char* src, std::size_t n) {
+        while (size - length < n) [[unlikely]] {
+            std::size_t room = size - length;
+            std::memcpy(active + length, src, room);
+            length += room;
+            src += room;
+            n -= room;
+            hand_off();
+        }
+        std::memcpy(active + length, src, n);
+        length += n;
+    }
 
-    inline std::size_t match_quote() const {
-        for (std::size_t it = token_current + 1; it < sv.length(); ++it) {
-            if (sv[it] == '"' && sv[it - 1] != '\\') {
-                return it;
+    // Writes out what is buffered and stops the writer thread. Returns 0 or 5.
+    int finish() {
+        if (writer.joinable()) {
+            hand_off();
+            {
+                std::lock_guard lock(mutex);
+                done = true;
             }
+            changed.notify_all();
+            writer.join();
+        }
+        return err;
+    }
+
+private:
+    int fd;
+    std::ostream* stream;
+    std::size_t size;
+    std::unique_ptr<char[]> storage;
+    char* active;
+    std::size_t length = 0ul;
+    std::mutex mutex;
+    std::condition_variable changed;
+    const char* pending = nullptr;  // buffer handed to the writer, guarded by mutex
+    std::size_t pending_length = 0ul;
+    bool done = false;
+    int err = 0;  // only touched by the writer until it is joined
+    std::thread writer;
+
+    // Waits until the writer is idle, gives it the active buffer and switches
+    // to the other one.
+    void hand_off() {
+        if (length == 0) { return; }
+        {
+            std::unique_lock lock(mutex);
+            changed.wait(lock, [&] { return pending == nullptr; });
+            pending = active;
+            pending_length = length;
         }
-        return sv.length();
+        changed.notify_all();
+        active = active == storage.get() ? storage.get() + size : storage.get();
+        length = 0;
     }
 
-    inline std::size_t try_read_number() const {
-        bool has_dot = false,
-             has_exp = false,
-             has_minus = sv[token_current] == '-';
-        std::size_t it = token_current + int(has_minus);
-        if (has_minus && it < sv.length() && std::isdigit(it)) {
-            return token_current;
+    void run() {
+        std::unique_lock lock(mutex);
+        while (true) {
+            changed.wait(lock, [&] { return pending != nullptr || done; });
+            if (!pending) { return; }
+            const char* data = pending;
+            std::size_t n = pending_length;
+            lock.unlock();
+            if (!err) { write_out(data, n); }
+            lock.lock();
+            pending = nullptr;
+            changed.notify_all();
         }
-        for (; it < sv.length(); ++it) {
-            if (std::isdigit(sv[it]) == 0) {
-                if (sv[it] == '.') {
-                    if (!has_dot) {
-                        has_dot = true;
-                        bool next_valid = it < (sv.length() - 1) &&
-                                            std::isdigit(sv[it + 1]);
-                        if (next_valid) {
-                            continue;
-                        }
-                    }
-                } else if (sv[it] == 'e' or sv[it] == 'E'){
-                   if (!has_exp) {
-                        has_exp = true;
-                        if (it < sv.length() - 1) {
-                            std::size_t exp_start = it;
-                            char followed_by = sv[exp_start + 1];
-                            if (followed_by == '+' or followed_by == '-') {
-                               ++exp_start; 
-                            }
-                            bool next_valid = exp_start < (sv.length() - 1) &&
-                                                std::isdigit(sv[exp_start + 1]);
-                            if (next_valid) {
-                                it = exp_start;
-                                continue;
-                            }
-                        }
-                   }
-                }
-                break;
+    }
+
+    void write_out(const char* data, std::size_t n) {
+        if (stream) {
+            if (!stream->write(data, static_cast<std::streamsize>(n))) { err = 5; }
+            return;
+        }
+        while (n > 0) {
+            ssize_t written = ::write(fd, data, n);
+            if (written < 0) {
+                if (errno == EINTR) { continue; }
+                err = 5;
+                return;
             }
+            data += written;
+            n -= static_cast<std::size_t>(written);
         }
-        return it;
     }
 };
+} // namespace detail
 
-#define DEFINE_CLASS_NAME(className) \
-    virtual std::string class_name() const override { return #className; }
+// Serializes `obj` straight to a file descriptor through two fixed-size
+// buffers, flushing each with write(2) on a background thread as it fills,
+// so output is written while serialization goes on and memory does not grow
+// with the output. Ranges, including lazy std::views pipelines, are
+// consumed element by element. Returns 0 on success and 5 if a write fails.
+template <typename T>
+int serialize_to(int fd, T&& obj, std::size_t buffer_size = std::size_t{1} << 20) {
+    detail::DoubleBufferedSink sink(fd, nullptr, buffer_size);
+    serialize_into(std::forward<T>(obj), sink);
+    return sink.finish();
+}
 
-class JsonNode {
-public:
-    virtual ~JsonNode() = default;
-    using NodePtr = std::shared_ptr<JsonNode>;
-#ifdef DEBUG
-    virtual std::string class_name() const = 0; 
-#endif
-};
+// As above, writing to `out` from the background thread; `out` must not be
+// used elsewhere until the call returns.
+template <typename T>
+int serialize_to(std::ostream& out, T&& obj, std::size_t buffer_size = std::size_t{1} << 20) {
+    detail::DoubleBufferedSink sink(-1, &out, buffer_size);
+    serialize_into(std::forward<T>(obj), sink);
+    return sink.finish();
+}
 
-class Null: public JsonNode {
-public:
-#ifdef DEBUG
-    DEFINE_CLASS_NAME(Null)
-#endif
-};
+namespace detail {
 
-class String: public JsonNode {
-public:
+// Runs fn(task) for every task in [0, tasks) on `threads` workers. Each
+// worker starts with a contiguous share of the tasks and takes them from
+// the front; once its share is empty it steals from the back of the others.
+template <typename Fn>
+void parallel_for(std::size_t tasks, std::size_t threads, Fn&& fn) {
+    threads = std::max<std::size_t>(1, std::min(threads, tasks));
+    if (threads == 1) {
+        for (std::size_t task = 0; task < tasks; ++task) { fn(task); }
+        return;
+    }
+    struct alignas(64) share {
+        std::mutex lock;
+        std::size_t begin = 0ul;
+        std::size_t end = 0ul;
+    };
+    std::vector<share> shares(threads);
+    for (std::size_t w = 0; w < threads; ++w) {
+        shares[w].begin = tasks * w / threads;
+        shares[w].end = tasks * (w + 1) / threads;
+    }
+    auto worker = [&](std::size_t self) {
+        while (true) {
+            std::size_t task = tasks;
+            {
+                std::lock_guard guard(shares[self].lock);
+                if (shares[self].begin < shares[self].end) { task = shares[self].begin++; }
+            }
+            for (std::size_t v = 1; task == tasks && v < threads; ++v) {
+                share& victim = shares[(self + v) % threads];
+                std::lock_guard guard(victim.lock);
+                if (victim.begin < victim.end) { task = --victim.end; }
+            }
+            if (task == tasks) { return; }
+            fn(task);
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (std::size_t w = 1; w < threads; ++w) { workers.emplace_back(worker, w); }
+    worker(0);
+    for (auto& thread : workers) { thread.join(); }
+}
 
-#ifdef DEBUG
-    DEFINE_CLASS_NAME(String)
-#endif
+inline std::size_t default_threads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+} // namespace detail
 
-    String(std::string_view sv) : str(sv) { }
-    std::string_view value() const { return str; }
-private:
-    std::string_view str;
-};
+// Serializes `records` as a JSON array, appending it to `out`. Chunks of
+// records are serialized concurrently into per-chunk buffers, which are
+// then stitched together in order. A `threads` of 0 runs on one thread.
+template <typename T>
+void serialize_parallel(std::span<const T> records, buffer& out,
+                        std::size_t threads = detail::default_threads()) {
+    threads = std::max<std::size_t>(threads, 1);
+    std::size_t chunks = std::min(records.size(), threads * 8);
+    std::vector<buffer> parts(chunks);
+    detail::parallel_for(chunks, threads, [&](std::size_t chunk) {
+        std::size_t first = records.size() * chunk / chunks;
+        std::size_t last = records.size() * (chunk + 1) / chunks;
+        for (std::size_t i = first; i < last; ++i) {
+            if (i != first) { parts[chunk].put(','); }
+            serialize_into(records[i], parts[chunk]);
+        }
+    });
+    std::size_t total = out.size() + 2 + chunks;
+    for (auto& part : parts) { total += part.size(); }
+    out.reserve(total);
+    out.put('[');
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+        if (chunk) { out.put(','); }
+        out.write(parts[chunk].data(), parts[chunk].size());
+    }
+    out.put(']');
+}
 
-template <numeric T>
-class Number: public JsonNode {
-public:
-    
-#ifdef DEBUG
-    DEFINE_CLASS_NAME(Number)
-#endif
+template <typename T>
+std::string serialize_parallel(std::span<const T> records,
+                               std::size_t threads = detail::default_threads()) {
+    buffer out;
+    serialize_parallel(records, out, threads);
+    return out.str();
+}
 
-    Number(T num) : number(num) { }
-    T value() const { return number; }
-private:
-    T number;
-};
+// Deserializes a top-level JSON array into `out`, resized to the number of
+// elements. Element boundaries come from one bracket-depth walk over the
+// structural index; chunks of elements are then deserialized concurrently,
+// each worker reading its slice of the same index. A `threads` of 0 runs
+// on one thread. Returns the error codes of deserialize().
+template <typename T>
+int deserialize_parallel(std::vector<T>& out, std::string_view json,
+                         std::size_t threads = detail::default_threads()) {
+    threads = std::max<std::size_t>(threads, 1);
+    if (json.size() > max_input_size) { return 8; }
+    detail::Tokenizer tokenizer(json);
+    std::span<const std::uint32_t> entries = tokenizer.structurals();
+    if (entries.empty() || json[entries.front()] != '[') { return 1; }
 
-class Bool: public JsonNode {
-public:
-   
-#ifdef DEBUG
-    DEFINE_CLASS_NAME(Bool)
-#endif
+    // starts[i] is the index entry where element i begins; the last entry of
+    // `starts` is the closing bracket.
+    std::vector<std::size_t> starts;
+    if (entries.size() > 1 && json[entries[1]] != ']') { starts.push_back(1); }
+    std::size_t depth = 1ul, close = entries.size();
+    for (std::size_t e = 1; e < entries.size(); ++e) {
+        char c = json[entries[e]];
+        if (c == '"') {
+            ++e;
+        } else if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                close = e;
+                break;
+            }
+        } else if (c == ',' && depth == 1) {
+            starts.push_back(e + 1);
+        }
+    }
+    if (close == entries.size()) { return 1; }
+    if (close + 1 != entries.size()) { return 2; }
+    starts.push_back(close);
 
-    Bool (bool b) : flag(b) { }
-    bool value() const { return flag; }
-private:
-    bool flag;
-};
+    std::size_t count = starts.size() - 1;
+    out.resize(count);
+    std::size_t chunks = std::min(count, threads * 8);
+    std::atomic<int> err{0};
+    detail::parallel_for(chunks, threads, [&](std::size_t chunk) {
+        std::size_t first = count * chunk / chunks;
+        std::size_t last = count * (chunk + 1) / chunks;
+        // Stop before the comma that separates this chunk from the next.
+        std::size_t slice_end = last == count ? close : starts[last] - 1;
+        detail::Tokenizer part(json, entries.subspan(starts[first], slice_end - starts[first]));
+        part.next();
+        for (std::size_t i = first; i < last && err.load(std::memory_order_relaxed) == 0; ++i) {
+            if (i != first) {
+                if (part.token != detail::Token::COMMA) { err = 1; return; }
+                part.skip_to_next();
+            }
+            if (int e = detail::deserializer_impl<T>::deserialize(out[i], part)) {
+                err = e;
+                return;
+            }
+        }
+        if (!part.is_end()) { err = 1; }
+    });
+    return err.load();
+}
 
-class Array: public JsonNode {
-public:
-    
-#ifdef DEBUG
-    DEFINE_CLASS_NAME(Array)
-#endif
+namespace detail {
 
-    void append(NodePtr value) { array.push_back(value); }
-    auto begin() { return array.begin(); }
-    auto end() { return array.end(); }
-    std::size_t size() { return array.size(); }
-private:
-    std::list<NodePtr> array;
-};
+// Binary layout: an 8-byte schema hash, then the value. Aggregates are their
+// members in declaration order with no names; ranges, maps and strings are
+// a varint count followed by the elements, key/value pairs or bytes; signed
+// integers are
+// zigzag varints, unsigned ones plain varints; floating-point values
+// are fixed-width little-endian; bool and the std::optional presence flag
+// are one byte. Elements of numeric ranges are fixed-width little-endian, so
+// contiguous ranges of them are copied in bulk.
 
-class Members: public JsonNode {
-public:
-    
-#ifdef DEBUG
-    DEFINE_CLASS_NAME(Members)
-#endif
+// 1-based position of T among the structs being hashed, or 0.
+template <typename T, typename... Open>
+constexpr std::size_t open_position() {
+    std::size_t position = 0ul, i = 0ul;
+    ((++i, position = std::same_as<T, Open> ? i : position), ...);
+    return position;
+}
 
-    void add(std::string_view key, NodePtr value) {
-        members.insert({key, value});
+// `Open` are the structs enclosing T; a struct that contains itself, e.g.
+// through a vector of children, hashes the inner reference by how many
+// levels up it points.
+template <typename T, typename... Open>
+constexpr std::uint64_t schema_hash() {
+    if constexpr (open_position<T, Open...>() != 0) {
+        return mix_seed(key_hash("recursive"), sizeof...(Open) - open_position<T, Open...>());
+    } else if constexpr (std::same_as<T, bool>) {
+        return key_hash("bool");
+    } else if constexpr (numeric_except_bool<T>) {
+        std::string_view kind = std::floating_point<T> ? "float" : std::is_signed_v<T> ? "int" : "uint";
+        return mix_seed(key_hash(kind), sizeof(T));
+    } else if constexpr (is_optional<T>::value) {
+        return mix_seed(key_hash("optional"), schema_hash<typename T::value_type, Open...>());
+    } else if constexpr (any_string<T>) {
+        return key_hash("string");
+    } else if constexpr (std::same_as<T, raw_json>) {
+        return key_hash("raw_json");
+    } else if constexpr (string_keyed_map<T>) {
+        return mix_seed(key_hash("map"), schema_hash<typename T::mapped_type, Open...>());
+    } else if constexpr (sized_forward_range<T>) {
+        return mix_seed(key_hash("range"), schema_hash<std::remove_cv_t<std::ranges::range_value_t<T>>, Open...>());
+    } else {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            std::uint64_t h = key_hash("{}");
+            ((h = mix_seed(h ^ key_hash(reflect::member_name<I, T>()),
+                           schema_hash<std::remove_cvref_t<decltype(reflect::get<I>(std::declval<T&>()))>, Open..., T>())), ...);
+            return h;
+        }(std::make_index_sequence<reflect::size<T>()>{});
     }
-    NodePtr& get(std::string_view key) { return members.at(key); }
-private:
-    std::map<std::string_view, NodePtr> members{};
-};
- 
-template <class T>
-std::shared_ptr<T> As(const std::shared_ptr<JsonNode>& obj) {
-    return std::dynamic_pointer_cast<T>(obj);
 }
 
-template <class T>
-bool Is(const std::shared_ptr<JsonNode>& obj) {
-    return std::dynamic_pointer_cast<T>(obj) != nullptr;
+template <typename T>
+inline constexpr bool bulk_copyable = numeric_except_bool<T> && std::endian::native == std::endian::little;
+
+template <typename Stream>
+inline void write_varint(std::uint64_t value, Stream& stream) {
+    char bytes[10];
+    std::size_t n = 0ul;
+    for (; value >= 0x80; value >>= 7) {
+        bytes[n++] = static_cast<char>(value | 0x80);
+    }
+    bytes[n++] = static_cast<char>(value);
+    stream.write(bytes, n);
 }
 
-std::shared_ptr<JsonNode> parse_json(Tokenizer*);
-std::shared_ptr<JsonNode> parse_array(Tokenizer*);
-std::shared_ptr<JsonNode> parse_string(Tokenizer* tokenizer) {
-    if (tokenizer->token != Token::QUOTE) { return nullptr; }
-    tokenizer->skip_to_next();
-    if (tokenizer->token != Token::STRING) { return nullptr; }
-    auto key = std::make_shared<String>(tokenizer->get_sv());
-    tokenizer->next();
-    if (tokenizer->token != Token::QUOTE) { return nullptr; }
-    tokenizer->skip_to_next();
-    return key;
-}
-
-std::shared_ptr<JsonNode> parse_value(Tokenizer* tokenizer) {
-    std::shared_ptr<JsonNode> value;
-    if (tokenizer->token == Token::CURLY_OPEN) {
-        value = parse_json(tokenizer);
-    } else if (tokenizer->token == Token::SQUARE_OPEN) {
-        value = parse_array(tokenizer);
-    } else if (tokenizer->token == Token::NUMBER_INT) {
-        value = std::make_shared<Number<long long>>(tokenizer->get_int());
-    } else if (tokenizer->token == Token::NUMBER_FLOAT) {
-        value = std::make_shared<Number<double>>(tokenizer->get_float());
-    } else if (tokenizer->token == Token::BOOL_TRUE ||
-               tokenizer->token == Token::BOOL_FALSE) {
-        value = std::make_shared<Bool>(tokenizer->get_sv() == "true");
-    } else if (tokenizer->token == Token::NULL_TOKEN) {
-        value = std::make_shared<Null>();
-        tokenizer->skip();
-    } else if (tokenizer->token == Token::QUOTE) {
-        value = parse_string(tokenizer); 
-    } else { 
-        return nullptr;
+template <numeric_except_bool T, typename Stream>
+inline void write_fixed(T value, Stream& stream) {
+    if constexpr (std::endian::native == std::endian::little) {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    } else {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        std::reverse(bytes, bytes + sizeof(T));
+        stream.write(bytes, sizeof(T));
     }
-    tokenizer->next();
-    return value;
 }
 
-std::shared_ptr<JsonNode> parse_array(Tokenizer* tokenizer) {
-    if (tokenizer->token != Token::SQUARE_OPEN) { return nullptr; }
-    tokenizer->skip_to_next();
-    auto array = std::make_shared<Array>();
-    while (!tokenizer->is_end()) {
-        std::shared_ptr<JsonNode> value = parse_value(tokenizer);
-#ifdef DEBUG
-        if (!value) { std::cout << "Could not parse value" << std::endl; }
-        else { std::cout << "Array value parsed correctly" << std::endl; }
-#endif
-        if (!value) { return nullptr; }
-        array->append(value);
+template <typename T>
+struct binary_serializer_impl {
+    template <typename U, typename Stream>
+    static void serialize(U&& obj, Stream& stream) {
+        if constexpr (reflect::size<T>() > 0) {
+            reflect::for_each([&](auto I) {
+                auto& ith_member = reflect::get<I>(obj);
+                using member_t = std::remove_cvref_t<decltype(ith_member)>;
+                binary_serializer_impl<member_t>::serialize(ith_member, stream);
+            }, obj);
+        }
+    }
+};
 
-        if (tokenizer->token == Token::COMMA) {
-            tokenizer->skip_to_next();
-        } else if (tokenizer->token == Token::SQUARE_CLOSE) {
-            tokenizer->skip_to_next();
-            break;
+template <sized_forward_range T>
+struct binary_serializer_impl<T> {
+    template <typename U, typename Stream>
+    static void serialize(U&& range, Stream& stream) {
+        using value_t = std::remove_cv_t<std::ranges::range_value_t<T>>;
+        std::size_t count = static_cast<std::size_t>(std::ranges::size(range));
+        write_varint(count, stream);
+        if constexpr (bulk_copyable<value_t> && std::ranges::contiguous_range<T>) {
+            stream.write(reinterpret_cast<const char*>(std::ranges::data(range)), count * sizeof(value_t));
+        } else if constexpr (numeric_except_bool<value_t>) {
+            for (auto&& element : range) { write_fixed<value_t>(element, stream); }
         } else {
-#ifdef DEBUG
-            std::cout << "No comma or closing square bracket" << std::endl;
-#endif
-            return nullptr;
+            for (auto&& element : range) { binary_serializer_impl<value_t>::serialize(element, stream); }
         }
     }
-    return array;
-}
+};
 
-std::shared_ptr<JsonNode> parse_json(Tokenizer* tokenizer) {
-    if (tokenizer->token != Token::CURLY_OPEN) { return nullptr; }
-    tokenizer->skip_to_next();
-    auto members = std::make_shared<Members>(); 
-    if (tokenizer->token == Token::CURLY_CLOSE) { 
-        tokenizer->skip_to_next();
-        return members; 
-    }
-    while (!tokenizer->is_end()) {
-        std::shared_ptr<JsonNode> name = parse_string(tokenizer);
-#ifdef DEBUG
-        if (!name) { std::cout << "Could not parse name" << std::endl; }
-        else { std::cout << "Name parsed correctly: " << As<String>(name)->value() << std::endl; }
-#endif  
-        if (!name) {
-            return nullptr;
+template <string_keyed_map T>
+struct binary_serializer_impl<T> {
+    template <typename U, typename Stream>
+    static void serialize(U&& map, Stream& stream) {
+        write_varint(static_cast<std::size_t>(std::ranges::size(map)), stream);
+        for (auto& [key, value] : map) {
+            binary_serializer_impl<typename T::key_type>::serialize(key, stream);
+            binary_serializer_impl<typename T::mapped_type>::serialize(value, stream);
         }
+    }
+};
 
-        if (tokenizer->token != Token::COLON) {
-#ifdef DEBUG
-            std::cout << "No colon after name" << std::endl;
-#endif
-            return nullptr;
+template <any_string T>
+struct binary_serializer_impl<T> {
+    template <typename U, typename Stream>
+    static void serialize(U&& obj, Stream& stream) {
+        std::string_view str{obj};
+        write_varint(str.size(), stream);
+        stream.write(str.data(), str.size());
+    }
+};
+
+// Written as a string holding the JSON text.
+template <>
+struct binary_serializer_impl<raw_json> {
+    template <typename Stream>
+    static void serialize(const raw_json& obj, Stream& stream) {
+        binary_serializer_impl<std::string_view>::serialize(obj.json(), stream);
+    }
+};
+
+template <numeric_except_bool T>
+struct binary_serializer_impl<T> {
+    template <typename Stream>
+    static void serialize(T obj, Stream& stream) {
+        if constexpr (std::floating_point<T>) {
+            write_fixed(obj, stream);
+        } else if constexpr (std::is_signed_v<T>) {
+            auto value = static_cast<std::int64_t>(obj);
+            write_varint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63), stream);
+        } else {
+            write_varint(static_cast<std::uint64_t>(obj), stream);
         }
-        tokenizer->skip_to_next();
+    }
+};
 
-        std::shared_ptr<JsonNode> value = parse_value(tokenizer);
-#ifdef DEBUG
-        if (!value) { std::cout << "Could not parse value" << std::endl; }
-        else { std::cout << "Value parsed correctly" << std::endl; }
-#endif  
-        if (!value) { return nullptr; }
+template <>
+struct binary_serializer_impl<bool> {
+    template <typename Stream>
+    static void serialize(bool obj, Stream& stream) { stream.put(obj ? 1 : 0); }
+};
 
-        members->add(As<String>(name)->value(), value);
-#ifdef DEBUG
-        std::cout << "Add new member" << std::endl;
-#endif
-        if (tokenizer->token == Token::COMMA) {
-            tokenizer->skip_to_next();
-        } else if (tokenizer->token == Token::CURLY_CLOSE) {
-            tokenizer->skip_to_next();
-            break;
+template <typename T>
+struct binary_serializer_impl<std::optional<T>> {
+    template <typename U, typename Stream>
+    static void serialize(U&& obj, Stream& stream) {
+        stream.put(obj ? 1 : 0);
+        if (obj) { binary_serializer_impl<T>::serialize(*obj, stream); }
+    }
+};
+
+// Bounds-checked cursor over a binary message.
+class BinaryReader {
+public:
+    BinaryReader(std::string_view input, std::size_t max_depth)
+        : cursor(input.data()), end(input.data() + input.size()), max_depth(max_depth) { }
+
+    bool at_end() const { return cursor == end; }
+    std::size_t remaining() const { return static_cast<std::size_t>(end - cursor); }
+
+    // The next `n` bytes, or nullptr if the input is shorter.
+    const char* take(std::size_t n) {
+        if (static_cast<std::size_t>(end - cursor) < n) { return nullptr; }
+        const char* bytes = cursor;
+        cursor += n;
+        return bytes;
+    }
+
+    bool read_varint(std::uint64_t& value) {
+        value = 0;
+        for (unsigned shift = 0; shift < 64 && cursor != end; shift += 7) {
+            auto byte = static_cast<unsigned char>(*cursor++);
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) { return true; }
+        }
+        return false;
+    }
+
+    template <numeric_except_bool T>
+    bool read_fixed(T& value) {
+        const char* bytes = take(sizeof(T));
+        if (!bytes) { return false; }
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(&value, bytes, sizeof(T));
         } else {
-            return nullptr;
+            char swapped[sizeof(T)];
+            std::reverse_copy(bytes, bytes + sizeof(T), swapped);
+            std::memcpy(&value, swapped, sizeof(T));
         }
+        return true;
     }
-    return members;
-}
+
+    // Reads a one-byte flag; anything but 0 or 1 is malformed.
+    bool read_flag(bool& flag) {
+        const char* byte = take(1);
+        if (!byte || (*byte != 0 && *byte != 1)) { return false; }
+        flag = *byte == 1;
+        return true;
+    }
+
+    // Counts a level of struct, range or map nesting; false once max_depth
+    // levels are open.
+    bool enter() {
+        if (depth == max_depth) { return false; }
+        ++depth;
+        return true;
+    }
+
+    void leave() { --depth; }
+
+private:
+    const char* cursor;
+    const char* end;
+    std::size_t max_depth;
+    std::size_t depth = 0ul;
+};
 
 template <typename To>
-struct deserializer_impl {
-    static int deserialize(To& obj, std::shared_ptr<JsonNode>& member_node) {
-        if (!member_node || !Is<Members>(member_node)) { return 1; }
+struct binary_deserializer_impl {
+    static int deserialize(To& obj, BinaryReader& reader) {
         int err = 0;
-        reflect::for_each([&](auto I) {
-            auto member_name = reflect::member_name<I, To>();
-            auto& ith_member = reflect::get<I>(obj);
-            auto& value = As<Members>(member_node)->get(member_name);
-            using member_t = std::remove_cvref_t<decltype(ith_member)>;
-            int err = deserializer_impl<member_t>::deserialize(ith_member, value);
-            err = std::max(0, err);
-        }, obj);
+        if constexpr (reflect::size<To>() > 0) {
+            if (!reader.enter()) { return 7; }
+            reflect::for_each([&](auto I) {
+                if (err) { return; }
+                auto& ith_member = reflect::get<I>(obj);
+                using member_t = std::remove_cvref_t<decltype(ith_member)>;
+                err = binary_deserializer_impl<member_t>::deserialize(ith_member, reader);
+            }, obj);
+            reader.leave();
+        }
         return err;
     }
-};   
+};
 
 template <sized_forward_range To>
-struct deserializer_impl<To> {
-    static int deserialize(To& obj, std::shared_ptr<JsonNode>& array_node) {
-        using value_t = std::ranges::range_value_t<To>;
-        if (!array_node || !Is<Array>(array_node)) { return 1; }
-        std::vector<value_t> array_deserialized;
-        array_deserialized.reserve(As<Array>(array_node)->size());
-        for (auto& it : *As<Array>(array_node)) {
-            value_t item{};
-            int err = deserializer_impl<value_t>::deserialize(item, it);
-            if (err) { return err; }
-            array_deserialized.push_back(item);
-        }
-        std::move(std::ranges::begin(array_deserialized),
-                  std::ranges::end(array_deserialized),
-                  std::ranges::begin(obj));
-        return 0;
+struct binary_deserializer_impl<To> {
+    static int deserialize(To& obj, BinaryReader& reader) {
+        if (!reader.enter()) { return 7; }
+        int err = elements(obj, reader);
+        reader.leave();
+        return err;
     }
-};
 
-template <numeric_except_bool To>
-struct deserializer_impl<To> {
-    static int deserialize(To& obj, std::shared_ptr<JsonNode>& number_node) {
-        if (!number_node || (!Is<Number<long long>>(number_node) && !Is<Number<double>>(number_node))) {
-            return 1;
+private:
+    static int elements(To& obj, BinaryReader& reader) {
+        using value_t = std::ranges::range_value_t<To>;
+        std::uint64_t count = 0;
+        if (!reader.read_varint(count)) { return 1; }
+        if constexpr (resizable_range<To>) {
+            // Every element takes at least one byte unless it is an empty struct.
+            if (!std::is_empty_v<value_t> && count > reader.remaining()) { return 1; }
+            obj.resize(static_cast<std::size_t>(count));
         }
-        if constexpr (std::is_integral_v<std::remove_cvref_t<To>>) {
-            obj = As<Number<long long>>(number_node)->value();
+        if (count > static_cast<std::uint64_t>(std::ranges::size(obj))) { return 1; }
+        if constexpr (bulk_copyable<value_t> && std::ranges::contiguous_range<To>) {
+            if (count > std::numeric_limits<std::size_t>::max() / sizeof(value_t)) { return 1; }
+            const char* bytes = reader.take(static_cast<std::size_t>(count) * sizeof(value_t));
+            if (!bytes) { return 1; }
+            if (count) { std::memcpy(std::ranges::data(obj), bytes, static_cast<std::size_t>(count) * sizeof(value_t)); }
+            return 0;
         } else {
-            obj = As<Number<double>>(number_node)->value();
+            auto it = std::ranges::begin(obj);
+            for (std::uint64_t i = 0; i < count; ++i, ++it) {
+                if constexpr (numeric_except_bool<value_t>) {
+                    if (!reader.read_fixed(*it)) { return 1; }
+                } else {
+                    if (int err = binary_deserializer_impl<value_t>::deserialize(*it, reader)) { return err; }
+                }
+            }
+            return 0;
         }
+    }
+};
+
+template <any_string To>
+struct binary_deserializer_impl<To> {
+    static int deserialize(To& obj, BinaryReader& reader) {
+        std::uint64_t length = 0;
+        if (!reader.read_varint(length) || length > std::numeric_limits<std::size_t>::max()) { return 1; }
+        const char* bytes = reader.take(static_cast<std::size_t>(length));
+        if (!bytes) { return 1; }
+        obj = std::string_view{bytes, static_cast<std::size_t>(length)};
         return 0;
     }
 };
 
 template <>
-struct deserializer_impl<bool> {
-    static int deserialize(bool& obj, std::shared_ptr<JsonNode>& bool_node) {
-        if (!bool_node || !Is<Bool>(bool_node)) {
-            return 1;
-        }
-        obj = As<Bool>(bool_node)->value();
+struct binary_deserializer_impl<raw_json> {
+    static int deserialize(raw_json& obj, BinaryReader& reader) {
+        std::string_view json;
+        if (int err = binary_deserializer_impl<std::string_view>::deserialize(json, reader)) { return err; }
+        obj = raw_json{json};
         return 0;
     }
 };
 
-template <any_string To>
-struct deserializer_impl<To> {
-    static int deserialize(To& obj, std::shared_ptr<JsonNode>& string_node) {
-        if (!string_node || !Is<String>(string_node)) { return 1; }
-        obj = As<String>(string_node)->value();
+template <string_keyed_map To>
+struct binary_deserializer_impl<To> {
+    static int deserialize(To& obj, BinaryReader& reader) {
+        std::uint64_t count = 0;
+        if (!reader.read_varint(count) || count > reader.remaining()) { return 1; }
+        if (!reader.enter()) { return 7; }
+        MapFiller<To> filler(obj);
+        for (std::uint64_t i = 0; i < count; ++i) {
+            std::string_view key;
+            if (int err = binary_deserializer_impl<std::string_view>::deserialize(key, reader)) { return err; }
+            if (int err = binary_deserializer_impl<typename To::mapped_type>::deserialize(filler.slot(key), reader)) {
+                return err;
+            }
+        }
+        filler.finish();
+        reader.leave();
         return 0;
     }
 };
 
+template <numeric_except_bool To>
+struct binary_deserializer_impl<To> {
+    static int deserialize(To& obj, BinaryReader& reader) {
+        if constexpr (std::floating_point<To>) {
+            return reader.read_fixed(obj) ? 0 : 1;
+        } else {
+            std::uint64_t raw = 0;
+            if (!reader.read_varint(raw)) { return 1; }
+            if constexpr (std::is_signed_v<To>) {
+                auto value = static_cast<std::int64_t>((raw >> 1) ^ (0 - (raw & 1)));
+                if (value < std::numeric_limits<To>::min() || value > std::numeric_limits<To>::max()) { return 3; }
+                obj = static_cast<To>(value);
+            } else {
+                if (raw > std::numeric_limits<To>::max()) { return 3; }
+                obj = static_cast<To>(raw);
+            }
+            return 0;
+        }
+    }
+};
+
+template <>
+struct binary_deserializer_impl<bool> {
+    static int deserialize(bool& obj, BinaryReader& reader) { return reader.read_flag(obj) ? 0 : 1; }
+};
+
 template <typename To>
-struct deserializer_impl<std::optional<To>> {
-    static int deserialize(std::optional<To>& to, std::shared_ptr<JsonNode>& opt) {
-        if (!opt) { return 1; }
-        if (Is<Null>(opt)) { to.reset(); return 0;}
-        To& temp = *to;
-        int err = deserializer_impl<To>::deserialize(temp, opt);
-        if (err) { return err; }
-        if (!to) { to = temp; }
-        return 0;
+struct binary_deserializer_impl<std::optional<To>> {
+    static int deserialize(std::optional<To>& to, BinaryReader& reader) {
+        bool present = false;
+        if (!reader.read_flag(present)) { return 1; }
+        if (!present) {
+            to.reset();
+            return 0;
+        }
+        if (!to) { to.emplace(); }
+        return binary_deserializer_impl<To>::deserialize(*to, reader);
     }
 };
-} //namespace detail
+} // namespace detail
 
+template <typename T, typename Stream>
+void serialize_binary_into(T&& obj, Stream& out) {
+    using type = std::remove_cvref_t<T>;
+    detail::write_fixed(detail::schema_hash<type>(), out);
+    detail::binary_serializer_impl<type>::serialize(std::forward<T>(obj), out);
+}
+
+template <typename T>
+std::string serialize_binary(T&& obj) {
+    buffer out;
+    serialize_binary_into(std::forward<T>(obj), out);
+    return out.str();
+}
+
+// Reads a message written by serialize_binary_into() for the same type.
+// Returns 0 on success, 1 if the input is truncated or malformed or a fixed-size
+// range has more elements than `to` holds, 2 if bytes follow the message, 3 if an
+// integer does not fit its field, 6 if the message was written for a
+// different schema (member names, order or types) and 7 if structs, ranges
+// and maps nest deeper than `max_depth`, which bounds the recursion of
+// self-referential types.
 template <typename To>
-int deserialize(To& to, std::string_view json) {
-    auto* tokenizer = new detail::Tokenizer(json);
-    tokenizer->next();
-    std::shared_ptr<detail::JsonNode> json_node = parse_json(tokenizer);
-    if (!tokenizer->is_end()) { return 2; }
-    delete tokenizer;
-    return detail::deserializer_impl<To>::deserialize(to, json_node);
+int deserialize_binary(To& to, std::string_view message, std::size_t max_depth = default_max_depth) {
+    detail::BinaryReader reader(message, max_depth);
+    std::uint64_t hash = 0;
+    if (!reader.read_fixed(hash)) { return 1; }
+    if (hash != detail::schema_hash<To>()) { return 6; }
+    if (int err = detail::binary_deserializer_impl<To>::deserialize(to, reader)) { return err; }
+    return reader.at_end() ? 0 : 2;
 }
 } // namespace serializez
-
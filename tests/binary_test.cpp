@@ -0,0 +1,65 @@
+#include <serialize.h>
+#include "check.h"
+#include <list>
+#include <map>
+
+struct point { double x; float y; };
+struct message {
+    int a; unsigned b; long long c; std::string s; std::array<double, 4> d; std::vector<point> points;
+    std::optional<int> o; std::optional<std::string> e; bool f; std::array<std::int8_t, 3> small;
+    std::list<short> l; std::map<std::string, int> m;
+};
+// Same layout as message with one member renamed.
+struct renamed {
+    int a; unsigned bb; long long c; std::string s; std::array<double, 4> d; std::vector<point> points;
+    std::optional<int> o; std::optional<std::string> e; bool f; std::array<std::int8_t, 3> small;
+    std::list<short> l; std::map<std::string, int> m;
+};
+struct narrow { std::int8_t v; };
+struct tree { int value; std::vector<tree> children; };
+struct wide { int v; };
+
+int main() {
+    message in{-5, 300, -1ll << 40, "h\xc3\xa9\"llo", {1.5, -2, 3, 4}, {{1, 2}, {3, 4}}, 7, std::nullopt, true,
+               {-1, 2, -3}, {1, -2, 3}, {{"k", 1}, {"q", -2}}};
+    std::string binary = serializez::serialize_binary(in);
+    std::string json = serializez::serialize(in);
+    CHECK(binary.size() < json.size());
+
+    message out{};
+    out.l.resize(1);
+    CHECK_EQ(serializez::deserialize_binary(out, binary), 0);
+    CHECK_EQ(serializez::serialize(out), json);
+
+    renamed other{};
+    CHECK_EQ(serializez::deserialize_binary(other, binary), 6);
+    CHECK_EQ(serializez::deserialize_binary(out, binary + "x"), 2);
+    for (std::size_t n = 0; n < binary.size(); ++n) {
+        message partial{};
+        CHECK_EQ(serializez::deserialize_binary(partial, std::string_view{binary}.substr(0, n)), 1);
+    }
+
+    // A value that does not fit the field is error 3.
+    std::string too_wide = serializez::serialize_binary(wide{1000});
+    too_wide.replace(0, 8, serializez::serialize_binary(narrow{}).substr(0, 8));
+    narrow n{};
+    CHECK_EQ(serializez::deserialize_binary(n, too_wide), 3);
+
+    // Nesting of a self-referential type is bounded instead of recursing
+    // until the stack overflows.
+    auto chain = [](std::size_t depth) {
+        std::string message = serializez::serialize_binary(tree{});
+        message.resize(8);
+        for (std::size_t i = 1; i < depth; ++i) { message += std::string("\x00\x01", 2); }
+        return message + std::string("\x00\x00", 2);
+    };
+    tree t{};
+    CHECK_EQ(serializez::deserialize_binary(t, chain(2000000)), 7);
+    // A tree level is a struct and its children vector.
+    CHECK_EQ(serializez::deserialize_binary(t, chain(serializez::default_max_depth / 2)), 0);
+    CHECK_EQ(serializez::deserialize_binary(t, chain(serializez::default_max_depth / 2 + 1)), 7);
+    CHECK_EQ(serializez::deserialize_binary(t, chain(3), 6), 0);
+    CHECK_EQ(serializez::serialize(t), R"({"value":0,"children":[{"value":0,"children":[{"value":0,"children":[]}]}]})");
+    CHECK_EQ(serializez::deserialize_binary(t, chain(4), 6), 7);
+    return report();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertions for the tests: a failed CHECK is reported and the test
+// keeps running, so one run lists every failure; main returns report().
+inline int failures = 0;
+
+#define CHECK(condition)                                                             \
+    do {                                                                             \
+        if (!(condition)) {                                                          \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                              \
+        }                                                                            \
+    } while (false)
+
+#define CHECK_EQ(actual, expected)                                                   \
+    do {                                                                             \
+        if (!((actual) == (expected))) {                                             \
+            std::fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed\n", __FILE__, __LINE__, #actual, #expected); \
+            ++failures;                                                              \
+        }                                                                            \
+    } while (false)
+
+inline int report() {
+    if (failures) { std::fprintf(stderr, "%d check(s) failed\n", failures); }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,50 @@
+#include <serialize.h>
+#include "check.h"
+#include <cmath>
+#include <map>
+
+struct inner { int a; double b; std::string s; };
+struct state {
+    inner in; std::optional<inner> maybe; std::optional<int> count; std::vector<int> values;
+    std::array<inner, 2> pair; std::map<std::string, int> tags; long long seq; double missing;
+};
+
+// Applies the delta from `prev` to `curr` on a copy of `prev` and checks
+// that it reproduces `curr`.
+bool applies(const state& prev, const state& curr) {
+    state copy = prev;
+    std::string delta = serializez::serialize_delta(prev, curr);
+    return serializez::apply_delta(copy, delta) == 0 && serializez::serialize(copy) == serializez::serialize(curr);
+}
+
+int main() {
+    state a{{1, 2.0, "x"}, inner{3, 4, "y"}, 5, {1, 2}, {inner{1, 1, "a"}, inner{2, 2, "b"}}, {{"k", 1}}, 100, NAN};
+    state b = a;
+    // NaN compares equal to NaN, so an unchanged snapshot is empty.
+    CHECK_EQ(serializez::serialize_delta(a, b), "{}");
+
+    b.in.b = 2.5;
+    b.maybe->s = "yy";
+    b.seq = 101;
+    b.values.push_back(3);
+    b.tags["z"] = 2;
+    CHECK_EQ(serializez::serialize_delta(a, b),
+             R"({"in":{"b":2.5},"maybe":{"s":"yy"},"values":[1,2,3],"tags":{"k":1,"z":2},"seq":101})");
+    CHECK(applies(a, b));
+
+    state cleared = b;
+    cleared.maybe.reset();
+    cleared.count.reset();
+    CHECK_EQ(serializez::serialize_delta(b, cleared), R"({"maybe":null,"count":null})");
+    CHECK(applies(b, cleared));
+
+    state refilled = cleared;
+    refilled.maybe = inner{9, 9, "n"};
+    CHECK_EQ(serializez::serialize_delta(cleared, refilled), R"({"maybe":{"a":9,"b":9,"s":"n"}})");
+    CHECK(applies(cleared, refilled));
+
+    state element = refilled;
+    element.pair[1].s = "c";
+    CHECK(applies(refilled, element));
+    return report();
+}
@@ -0,0 +1,66 @@
+#include <serialize.h>
+#include "check.h"
+
+struct node { int v; std::vector<node> kids; };
+
+std::string nested(std::size_t depth) { return std::string(depth, '[') + std::string(depth, ']'); }
+
+int push(std::string_view json, std::size_t max_depth = serializez::default_max_depth) {
+    serializez::Document doc;
+    serializez::push_parser parser(doc, max_depth);
+    if (int err = parser.feed(json)) { return err; }
+    return parser.finish();
+}
+
+int main() {
+    // Every entry point accepts default_max_depth levels and rejects one more.
+    serializez::Document doc;
+    for (std::size_t depth : {1ul, serializez::default_max_depth, serializez::default_max_depth + 1, 100000ul}) {
+        std::string json = nested(depth);
+        int expected = depth > serializez::default_max_depth ? 7 : 0;
+        CHECK_EQ(serializez::parse(json, doc), expected);
+        CHECK_EQ(push(json), expected);
+        CHECK_EQ(serializez::validate(json).error, expected);
+    }
+
+    // Lower limits are honored by all of them.
+    serializez::options opts;
+    opts.max_depth = 3;
+    CHECK_EQ(serializez::parse("[[[1]]]", doc, opts), 0);
+    CHECK_EQ(serializez::parse("[[[[1]]]]", doc, opts), 7);
+    serializez::stats measured;
+    opts.sink = &measured;
+    CHECK_EQ(serializez::parse("[[[1]]]", doc, opts), 0);
+    CHECK_EQ(measured.max_depth, 3ul);
+    CHECK_EQ(serializez::parse("[[[[1]]]]", doc, opts), 7);
+    opts.sink = nullptr;
+    CHECK_EQ(push("[[[1]]]", 3), 0);
+    CHECK_EQ(push("[[[[1]]]]", 3), 7);
+    CHECK_EQ(serializez::validate("[[[1]]]", 3).error, 0);
+    CHECK_EQ(serializez::validate("[[[[1]]]]", 3).error, 7);
+    CHECK_EQ(serializez::validate("[[[[1]]]]", 3).offset, 3ul);
+    CHECK_EQ(serializez::validate(R"({"a":{"b":{"c":{}}}})", 3).error, 7);
+
+    // validate() cannot go deeper than its fixed stack; parse() can.
+    std::string deeper = nested(serializez::default_max_depth + 1);
+    CHECK_EQ(serializez::validate(deeper, serializez::default_max_depth + 1).error, 7);
+    opts.max_depth = 2000000;
+    CHECK_EQ(serializez::parse(nested(2000000), doc, opts), 0);
+
+    // Typed input is limited the same way; deserialize() recurses, but only
+    // max_depth levels deep.
+    std::string typed;
+    for (int i = 0; i < 5000; ++i) { typed += R"({"v":1,"kids":[)"; }
+    for (int i = 0; i < 5000; ++i) { typed += "]}"; }
+    node n{};
+    CHECK_EQ(serializez::deserialize(n, std::string_view{typed}), 7);
+    std::string shallow = R"({"v":1,"kids":[{"v":2,"kids":[]},{"v":3,"kids":[{"v":4,"kids":[]}]}]})";
+    CHECK_EQ(serializez::deserialize(n, std::string_view{shallow}), 0);
+    CHECK_EQ(serializez::serialize(n), shallow);
+    opts.max_depth = 5;
+    CHECK_EQ(serializez::deserialize(n, std::string_view{shallow}, opts), 7);
+    opts.max_depth = 6;
+    CHECK_EQ(serializez::deserialize(n, std::string_view{shallow}, opts), 0);
+
+    return report();
+}
@@ -0,0 +1,47 @@
+#include <serialize.h>
+#include "check.h"
+
+int main() {
+    serializez::Document doc;
+    std::string json = R"({"user":{"id":42,"name":"ann"},"ratio":0.5,"ok":true,"tags":["a",1],"last":null})";
+    CHECK_EQ(serializez::parse(json, doc), 0);
+    serializez::Element root = doc.root();
+    CHECK_EQ(root["user"]["id"].get_int(), 42);
+    CHECK(root["user"]["name"].get_string() == "ann");
+    CHECK_EQ(root["ratio"].get_float(), 0.5);
+    CHECK_EQ(root["user"]["id"].get_float(), 42.0);
+    CHECK(root["ok"].get_bool());
+    CHECK_EQ(root["tags"].size(), 2ul);
+    CHECK_EQ(root.size(), 5ul);
+
+    // Missing elements and elements of another type read as empty values.
+    serializez::Element missing = root["account"]["id"];
+    CHECK(!missing);
+    CHECK_EQ(missing.get_int(), 0);
+    CHECK_EQ(missing.get_float(), 0.0);
+    CHECK(missing.get_string().empty());
+    CHECK(!missing.get_bool());
+    CHECK_EQ(missing.size(), 0ul);
+    CHECK(missing.begin() == missing.end());
+    CHECK(missing.json().empty());
+    CHECK(root["last"].get_string().empty());
+    CHECK_EQ(root["last"].get_int(), 0);
+    CHECK_EQ(root["ok"].get_float(), 0.0);
+    CHECK_EQ(root["ratio"].get_int(), 0);
+    CHECK(root["user"].get_string().empty());
+    CHECK_EQ(root["user"]["name"].get_int(), 0);
+    CHECK(!root["tags"]["a"]);
+
+    // A trailing null is the last entry of the tape.
+    CHECK_EQ(serializez::parse("null", doc), 0);
+    CHECK(doc.root().is_null());
+    CHECK(doc.root().get_string().empty());
+    CHECK_EQ(doc.root().get_float(), 0.0);
+
+    // A failed parse leaves no root.
+    CHECK_EQ(serializez::parse("{\"a\":", doc), 1);
+    CHECK(!doc.root());
+    CHECK_EQ(doc.root()["a"].get_int(), 0);
+
+    return report();
+}
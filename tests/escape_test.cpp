@@ -0,0 +1,52 @@
+#include <serialize.h>
+#include "check.h"
+
+struct strings { std::string owned; std::string_view view; };
+struct text { std::string value; };
+
+int main() {
+    std::string json = R"({"owned":"q\"\\\/\b\f\n\r\té€😀x","view":"plain"})";
+    strings s{};
+    CHECK_EQ(serializez::deserialize(s, json), 0);
+    CHECK_EQ(s.owned, "q\"\\/\b\f\n\r\t\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80x");
+    CHECK(s.view == "plain");
+    CHECK(s.view.data() > json.data() && s.view.data() < json.data() + json.size());
+
+    // Escaped strings bound to std::string_view need an arena.
+    std::string escaped = R"({"owned":"x","view":"esc\naped"})";
+    CHECK_EQ(serializez::deserialize(s, escaped), 1);
+    char scratch[256];
+    std::pmr::monotonic_buffer_resource arena(scratch, sizeof(scratch));
+    serializez::options opts;
+    opts.string_arena = &arena;
+    CHECK_EQ(serializez::deserialize(s, escaped, opts), 0);
+    CHECK(s.view == "esc\naped");
+    CHECK(s.view.data() >= scratch && s.view.data() < scratch + sizeof(scratch));
+
+    for (std::string_view bad : {R"({"value":"\ud83d"})", R"({"value":"\ude00"})", R"({"value":"\x"})",
+                                 R"({"value":"\u12g4"})", R"({"value":"\ud83dA"})"}) {
+        text t{};
+        CHECK_EQ(serializez::deserialize(t, bad), 1);
+    }
+
+    text control{std::string("ctl\x01\x1f\"\\ \xc3\xa9", 10)};
+    std::string written = serializez::serialize(control);
+    text back{};
+    CHECK_EQ(serializez::deserialize(back, written), 0);
+    CHECK_EQ(back.value, control.value);
+
+    serializez::Document doc;
+    std::string dom = R"({"k\"ey":"vé","arr":["a\tb","plain",{"n":"😀"}],"z":1})";
+    CHECK_EQ(serializez::parse(dom, doc), 0);
+    auto root = doc.root();
+    CHECK(root.begin().key() == "k\"ey");
+    CHECK(root["k\"ey"].get_string() == "v\xc3\xa9");
+    auto element = root["arr"].begin();
+    CHECK((*element).get_string() == "a\tb");
+    ++element;
+    CHECK((*element).get_string() == "plain");
+    ++element;
+    CHECK((*element)["n"].get_string() == "\xf0\x9f\x98\x80");
+    CHECK_EQ(root["z"].get_int(), 1);
+    return report();
+}
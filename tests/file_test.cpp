@@ -0,0 +1,38 @@
+#include <serialize.h>
+#include "check.h"
+#include <cstdlib>
+#include <fstream>
+#include <map>
+
+struct tree { int value; std::vector<tree> children; };
+struct owning { std::string name; std::optional<std::vector<tree>> trees; std::map<std::string, int> counts; };
+struct viewing { int id; std::optional<std::map<std::string, std::string_view>> labels; };
+struct raw_holder { serializez::raw_json payload; };
+
+// deserialize_file(to, path) only accepts types that own their data.
+static_assert(!serializez::detail::views_input<tree>());
+static_assert(!serializez::detail::views_input<owning>());
+static_assert(serializez::detail::views_input<viewing>());
+static_assert(serializez::detail::views_input<raw_holder>());
+
+int main() {
+    std::string path = "file_test.json";
+    std::ofstream(path) << R"({"id":7,"labels":{"k":"v"}})";
+
+    viewing in_place{};
+    serializez::mapped_file mapping;
+    CHECK_EQ(serializez::deserialize_file(in_place, path, mapping), 0);
+    CHECK_EQ(in_place.id, 7);
+    CHECK(in_place.labels && in_place.labels->at("k") == "v");
+
+    std::ofstream(path) << R"({"name":"n","trees":[{"value":1,"children":[]}],"counts":{"a":2}})";
+    owning copied{};
+    CHECK_EQ(serializez::deserialize_file(copied, path), 0);
+    CHECK_EQ(copied.name, "n");
+    CHECK(copied.trees && copied.trees->size() == 1);
+    CHECK_EQ(copied.counts["a"], 2);
+
+    CHECK_EQ(serializez::deserialize_file(copied, "missing.json"), 5);
+    std::remove(path.c_str());
+    return report();
+}
@@ -0,0 +1,80 @@
+#include <serialize.h>
+#include "check.h"
+
+struct header { int id; std::string_view name; };
+
+int main() {
+    std::string json = R"({"meta":{"skip":[1,[2,{"x":"}]"}],3],"s":"a\"b"},)"
+                       R"("user":{"name":"bob","id":42,"tags":["a","b","c"]},)"
+                       R"("list":[10,20,{"k":true},40],"n":null,"h":{"zz":[1],"id":7,"name":"hi"}})";
+    serializez::json_view doc(json);
+    auto user = doc["user"];
+    CHECK_EQ(user["id"].get<std::int64_t>(), 42);
+    CHECK(user["tags"][2].get<std::string_view>() == "c");
+    // "name" comes before the values already visited.
+    CHECK(!user["name"]);
+
+    auto list = doc["list"];
+    CHECK_EQ(list[1].get<int>(), 20);
+    CHECK(list[2]["k"].get<bool>());
+    CHECK_EQ(list[3].get<int>(), 40);
+    CHECK(!list[9]);
+    CHECK(doc["n"].is_null());
+
+    header h{};
+    CHECK_EQ(doc["h"].get(h), 0);
+    CHECK_EQ(h.id, 7);
+    CHECK(h.name == "hi");
+    CHECK(!doc["meta"]);
+    CHECK_EQ(doc.error(), 0);
+
+    serializez::json_view array(R"([1,2,3])");
+    CHECK_EQ(array[0].get<int>(), 1);
+    CHECK_EQ(array[2].get<int>(), 3);
+    CHECK(!array[1]);
+
+    serializez::json_view truncated(R"({"a":[1,2,{"b":)");
+    CHECK(!truncated["zz"]);
+    CHECK_EQ(truncated.error(), 1);
+
+    // A get() of the wrong type consumes nothing and can be retried.
+    serializez::json_view mixed(R"({"a":"text","b":2,"c":[1,"x"],"d":4})");
+    auto a = mixed["a"];
+    CHECK_EQ(a.get<int>(), 0);
+    int number = 0;
+    CHECK_EQ(a.get(number), 1);
+    CHECK(a.get<std::string>() == "text");
+    CHECK_EQ(mixed["b"].get<int>(), 2);
+    CHECK_EQ(mixed.error(), 0);
+    // One that fails inside an array stops the view.
+    std::vector<int> numbers;
+    CHECK_EQ(mixed["c"].get(numbers), 1);
+    CHECK(!mixed["d"]);
+    CHECK_EQ(mixed.error(), 1);
+
+    // Escaped strings read as views need an arena, given through options.
+    std::string escaped = R"({"s":"a\nb","t":1})";
+    serializez::json_view plain(escaped);
+    CHECK_EQ(plain["s"].get<std::string_view>(), "");
+    CHECK_EQ(plain["t"].get<int>(), 1);
+    char scratch[64];
+    std::pmr::monotonic_buffer_resource arena(scratch, sizeof(scratch));
+    serializez::options opts;
+    opts.string_arena = &arena;
+    serializez::json_view decoded(escaped, opts);
+    CHECK(decoded["s"].get<std::string_view>() == "a\nb");
+    CHECK_EQ(decoded["t"].get<int>(), 1);
+    CHECK_EQ(decoded.error(), 0);
+
+    // Members are separated by commas, as deserialize() requires.
+    serializez::json_view no_comma(R"({"a":1 "b":2})");
+    CHECK(!no_comma["b"]);
+    CHECK_EQ(no_comma.error(), 1);
+    serializez::json_view trailing(R"({"a":1,})");
+    CHECK(!trailing["b"]);
+    CHECK_EQ(trailing.error(), 1);
+    serializez::json_view leading(R"({,"a":1})");
+    CHECK(!leading["a"]);
+    CHECK_EQ(leading.error(), 1);
+    return report();
+}
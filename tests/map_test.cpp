@@ -0,0 +1,71 @@
+#include <serialize.h>
+#include "check.h"
+#include <map>
+#include <unordered_map>
+
+struct holder { std::map<std::string, int> m; };
+
+template <typename Map>
+std::string keys_of(const Map& map) {
+    std::string keys;
+    for (const auto& [key, value] : map) { keys += key + "=" + std::to_string(value) + ";"; }
+    return keys;
+}
+
+int main() {
+    // Escaped keys are decoded on every path, and written back escaped.
+    std::map<std::string, int> escaped{{"x\ny", 1}, {"q\"\\", 2}, {"\xc3\xa9", 3}};
+    std::string json = serializez::serialize(escaped);
+    CHECK_EQ(json, R"({"q\"\\":2,"x\ny":1,"é":3})");
+    std::map<std::string, int> back;
+    CHECK_EQ(serializez::deserialize(back, json), 0);
+    CHECK(back == escaped);
+    std::map<std::string, int> unicode;
+    CHECK_EQ(serializez::deserialize(unicode, std::string_view{R"({"a\u0062":1,"\u00e9":2})"}), 0);
+    CHECK_EQ(keys_of(unicode), "ab=1;\xc3\xa9=2;");
+    CHECK_EQ(serializez::deserialize(unicode, std::string_view{R"({"a\qb":1})"}), 1);
+    CHECK_EQ(serializez::deserialize(unicode, std::string_view{"{\"a\tb\":1}"}), 1);
+
+    holder dom{};
+    serializez::Document doc;
+    CHECK_EQ(serializez::parse(json, doc), 0);
+    CHECK_EQ(serializez::deserialize(dom.m, doc.root()), 0);
+    CHECK(dom.m == escaped);
+
+    // Maps keyed by views decode escaped keys into the string arena.
+    std::map<std::string_view, int> views;
+    CHECK_EQ(serializez::deserialize(views, json), 1);
+    char scratch[64];
+    std::pmr::monotonic_buffer_resource arena(scratch, sizeof(scratch));
+    serializez::options opts;
+    opts.string_arena = &arena;
+    CHECK_EQ(serializez::deserialize(views, json, opts), 0);
+    CHECK_EQ(views.size(), 3ul);
+    CHECK_EQ(views.at("x\ny"), 1);
+
+    // Refilling keeps only the keys of the input, also when keys repeat.
+    std::map<std::string, int> filled{{"a", 0}, {"b", 0}};
+    CHECK_EQ(serializez::deserialize(filled, std::string_view{R"({"a":1,"a":2})"}), 0);
+    CHECK_EQ(keys_of(filled), "a=2;");
+    filled = {{"a", 0}, {"b", 0}};
+    CHECK_EQ(serializez::deserialize(filled, std::string_view{R"({"b":1,"c":2,"c":3})"}), 0);
+    CHECK_EQ(keys_of(filled), "b=1;c=3;");
+    filled = {{"a", 0}, {"b", 0}};
+    CHECK_EQ(serializez::deserialize(filled, std::string_view{R"({"b":1,"a":2})"}), 0);
+    CHECK_EQ(keys_of(filled), "a=2;b=1;");
+    std::unordered_map<std::string, int> hashed{{"a", 0}, {"b", 0}, {"c", 0}};
+    CHECK_EQ(serializez::deserialize(hashed, std::string_view{R"({"c":1,"c":2,"b":3})"}), 0);
+    CHECK_EQ(hashed.size(), 2ul);
+    CHECK_EQ(hashed.at("c"), 2);
+
+    // The binary format and the DOM fill maps the same way.
+    filled = {{"a", 0}, {"b", 0}};
+    CHECK_EQ(serializez::parse(std::string_view{R"({"a":1,"a":2})"}, doc), 0);
+    CHECK_EQ(serializez::deserialize(filled, doc.root()), 0);
+    CHECK_EQ(keys_of(filled), "a=2;");
+    filled = {{"stale", 0}};
+    CHECK_EQ(serializez::deserialize_binary(filled, serializez::serialize_binary(escaped)), 0);
+    CHECK(filled == escaped);
+
+    return report();
+}
@@ -0,0 +1,78 @@
+#include <serialize.h>
+#include "check.h"
+#include <cstdint>
+#include <limits>
+#include <random>
+
+struct numbers {
+    std::int8_t i8; std::uint8_t u8;
+    std::int16_t i16; std::uint16_t u16;
+    std::int32_t i32; std::uint32_t u32;
+    std::int64_t i64; std::uint64_t u64;
+    float f32;
+    double f64;
+};
+
+std::mt19937_64 rng{20240601};
+
+template <typename T>
+T random_value() {
+    if constexpr (std::is_integral_v<T>) {
+        return static_cast<T>(rng());
+    } else {
+        // Random bit patterns cover subnormals and every exponent; NaN and
+        // infinity are written as null and are not round-tripped.
+        using bits_t = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+        T value;
+        do { value = std::bit_cast<T>(static_cast<bits_t>(rng())); } while (!std::isfinite(value));
+        return value;
+    }
+}
+
+template <typename T>
+bool same_bits(T a, T b) {
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+bool round_trips(const numbers& in) {
+    std::string json = serializez::serialize(in);
+    numbers out{};
+    if (serializez::deserialize(out, std::string_view{json}) != 0) { return false; }
+    return same_bits(in.i8, out.i8) && same_bits(in.u8, out.u8) && same_bits(in.i16, out.i16) &&
+           same_bits(in.u16, out.u16) && same_bits(in.i32, out.i32) && same_bits(in.u32, out.u32) &&
+           same_bits(in.i64, out.i64) && same_bits(in.u64, out.u64) && same_bits(in.f32, out.f32) &&
+           same_bits(in.f64, out.f64);
+}
+
+template <typename T>
+using limits = std::numeric_limits<T>;
+
+int main() {
+    numbers lowest{limits<std::int8_t>::lowest(), 0, limits<std::int16_t>::lowest(), 0,
+                   limits<std::int32_t>::lowest(), 0, limits<std::int64_t>::lowest(), 0,
+                   limits<float>::lowest(), limits<double>::lowest()};
+    numbers highest{limits<std::int8_t>::max(), limits<std::uint8_t>::max(), limits<std::int16_t>::max(),
+                    limits<std::uint16_t>::max(), limits<std::int32_t>::max(), limits<std::uint32_t>::max(),
+                    limits<std::int64_t>::max(), limits<std::uint64_t>::max(), limits<float>::max(),
+                    limits<double>::max()};
+    numbers tiny{-1, 1, -10, 10, -99, 100, -100, 99, limits<float>::denorm_min(), limits<double>::denorm_min()};
+    numbers negative_zero{0, 0, 0, 0, 0, 0, 0, 0, -0.0f, -0.0};
+    CHECK(round_trips(lowest));
+    CHECK(round_trips(highest));
+    CHECK(round_trips(tiny));
+    CHECK(round_trips(negative_zero));
+
+    for (int i = 0; i < 100000; ++i) {
+        numbers record{random_value<std::int8_t>(), random_value<std::uint8_t>(),
+                       random_value<std::int16_t>(), random_value<std::uint16_t>(),
+                       random_value<std::int32_t>(), random_value<std::uint32_t>(),
+                       random_value<std::int64_t>(), random_value<std::uint64_t>(),
+                       random_value<float>(), random_value<double>()};
+        if (!round_trips(record)) {
+            std::fprintf(stderr, "not round-tripped: %s\n", serializez::serialize(record).c_str());
+            CHECK(false);
+            break;
+        }
+    }
+    return report();
+}
@@ -0,0 +1,53 @@
+#include <serialize.h>
+#include "check.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+struct point { int id; double x; std::string label; std::vector<int> tags; };
+
+std::vector<point> make_points(std::size_t n) {
+    std::vector<point> points;
+    for (std::size_t i = 0; i < n; ++i) {
+        points.push_back({static_cast<int>(i), i * 0.5, "p" + std::to_string(i), std::vector<int>(i % 4, 7)});
+    }
+    return points;
+}
+
+int main() {
+    for (std::size_t n : {0ul, 1ul, 7ul, 1000ul}) {
+        std::vector<point> points = make_points(n);
+        std::string expected = serializez::serialize(points);
+        for (std::size_t threads : {0ul, 1ul, 4ul}) {
+            std::string json = serializez::serialize_parallel(std::span<const point>{points}, threads);
+            CHECK_EQ(json, expected);
+            std::vector<point> back(3);
+            CHECK_EQ(serializez::deserialize_parallel(back, json, threads), 0);
+            CHECK_EQ(serializez::serialize(back), expected);
+        }
+    }
+
+    std::vector<point> out;
+    CHECK_EQ(serializez::deserialize_parallel(out, R"([{"id":1},{"id":"x"}])", 4), 1);
+    CHECK_EQ(serializez::deserialize_parallel(out, R"([{"id":1}] [])", 4), 2);
+    CHECK_EQ(serializez::deserialize_parallel(out, R"([{"id":1},)", 4), 1);
+
+    // Input past max_input_size is rejected up front with its own error
+    // code; the sparse file is mapped but never read.
+    const char* path = "parallel_test_large.json";
+    int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    CHECK(fd >= 0);
+    if (fd >= 0 && ::ftruncate(fd, static_cast<off_t>(serializez::max_input_size) + 1) == 0) {
+        serializez::mapped_file mapping;
+        CHECK_EQ(mapping.open(path), 0);
+        std::string_view large = mapping.view();
+        CHECK_EQ(large.size(), serializez::max_input_size + 1);
+        CHECK_EQ(serializez::deserialize_parallel(out, large, 4), 8);
+        CHECK_EQ(serializez::deserialize(out, large), 8);
+        serializez::Document doc;
+        CHECK_EQ(serializez::parse(large, doc), 8);
+        CHECK_EQ(serializez::json_view(large).error(), 8);
+    }
+    if (fd >= 0) { ::close(fd); }
+    ::unlink(path);
+    return report();
+}
@@ -0,0 +1,81 @@
+#include <serialize.h>
+#include "check.h"
+#include <map>
+
+struct item { std::string name; std::vector<int> values; std::optional<double> weight; };
+struct message {
+    int id; std::vector<item> items; std::map<std::string, int> counts; bool ok; std::string_view tag; unsigned big;
+};
+struct reals { double d; float f; };
+struct keyed { std::string k; };
+
+// Binds the document to a message and writes it back, or returns the error.
+std::string rebind(const serializez::Document& doc) {
+    message m{};
+    if (int err = serializez::deserialize(m, doc.root())) { return "error " + std::to_string(err); }
+    return serializez::serialize(m);
+}
+
+int feed_in_chunks(serializez::Document& doc, std::string_view json, std::size_t chunk) {
+    serializez::push_parser parser(doc);
+    for (std::size_t i = 0; i < json.size(); i += chunk) {
+        if (int err = parser.feed(json.substr(i, chunk))) { return err; }
+    }
+    return parser.finish();
+}
+
+int main() {
+    message in{42, {{"n\"ame\\x", {1, -2, 3}, 1.5}, {"\xc3\xa9\xf0\x9f\x98\x80", {}, std::nullopt}},
+               {{"k", 1}, {"z", -7}}, true, "view", 4000000000u};
+    std::string expected = serializez::serialize(in);
+    std::string json = " \n" + expected + " \t";
+
+    // Every chunking gives the same document as parse().
+    serializez::Document parsed;
+    CHECK_EQ(serializez::parse(json, parsed), 0);
+    CHECK_EQ(rebind(parsed), expected);
+    for (std::size_t chunk = 1; chunk <= json.size(); ++chunk) {
+        serializez::Document doc;
+        CHECK_EQ(feed_in_chunks(doc, json, chunk), 0);
+        CHECK_EQ(rebind(doc), expected);
+    }
+
+    for (std::string_view bad : {"[1,2", "{\"a\" 1}", "tru", "\"abc", "[-]", "{\"a\":1]", "[\"\\ud800\"]", "01"}) {
+        serializez::Document doc;
+        CHECK_EQ(feed_in_chunks(doc, bad, 1), 1);
+    }
+    serializez::Document trailing;
+    CHECK_EQ(feed_in_chunks(trailing, "[1] 2", 2), 2);
+
+    // Raw control characters are rejected by every entry point, in values
+    // and in keys, before and after escapes.
+    for (std::string_view text : {"[\"a\x01\"]", "[\"a\\n\x1f\"]", "{\"k\x02\":\"v\"}", "{\"k\":\"\tv\"}"}) {
+        serializez::Document doc;
+        std::vector<std::string> list;
+        std::map<std::string, std::string> map;
+        keyed typed{};
+        bool object = text.front() == '{';
+        CHECK_EQ(serializez::parse(text, doc), 1);
+        CHECK_EQ(object ? serializez::deserialize(map, text) : serializez::deserialize(list, text), 1);
+        CHECK_EQ(feed_in_chunks(doc, text, 1), 1);
+        if (object) { CHECK_EQ(serializez::deserialize(typed, text), 1); }
+    }
+
+    // Integers, including zero and negative ones, bind to floating-point fields.
+    for (std::string_view text : {R"({"d":0,"f":0})", R"({"d":-5,"f":-5})", R"({"d":7,"f":7})"}) {
+        reals direct{}, bound{};
+        serializez::Document doc;
+        CHECK_EQ(serializez::deserialize(direct, text), 0);
+        CHECK_EQ(serializez::parse(text, doc), 0);
+        CHECK_EQ(serializez::deserialize(bound, doc.root()), 0);
+        CHECK(bound.d == direct.d && bound.f == direct.f);
+    }
+    reals zero{};
+    std::string zero_json = serializez::serialize(zero);
+    serializez::Document zero_doc;
+    CHECK_EQ(feed_in_chunks(zero_doc, zero_json, 3), 0);
+    reals zero_back{1, 1};
+    CHECK_EQ(serializez::deserialize(zero_back, zero_doc.root()), 0);
+    CHECK(zero_back.d == 0.0 && zero_back.f == 0.0f);
+    return report();
+}
@@ -0,0 +1,88 @@
+#include <serialize.h>
+#include "check.h"
+
+struct payload { int id; std::string name; std::vector<int> tags; };
+struct envelope {
+    std::string route; serializez::raw_json body; serializez::raw_json extra; int seq;
+    std::optional<serializez::raw_json> opt;
+};
+struct wrapped { serializez::raw_json value; };
+
+std::string_view text_of(const serializez::raw_json& raw) { return raw.json(); }
+
+int main() {
+    std::string in = R"({"route":"a", "body" : {"id":7,"name":"x\"}","tags":[1,2,{"z":[]}]} , )"
+                     R"("extra":  12.5e3 ,"seq":3,"opt":"s\"tr"})";
+    std::string out = R"({"route":"a","body":{"id":7,"name":"x\"}","tags":[1,2,{"z":[]}]},)"
+                      R"("extra":12.5e3,"seq":3,"opt":"s\"tr"})";
+
+    // deserialize() captures the verbatim text and serialize() writes it back.
+    envelope e{};
+    CHECK_EQ(serializez::deserialize(e, std::string_view{in}), 0);
+    CHECK_EQ(text_of(e.body), R"({"id":7,"name":"x\"}","tags":[1,2,{"z":[]}]})");
+    CHECK_EQ(text_of(e.extra), "12.5e3");
+    CHECK_EQ(text_of(*e.opt), R"("s\"tr")");
+    CHECK(e.body.json().data() > in.data() && e.body.json().data() < in.data() + in.size());
+    CHECK_EQ(serializez::serialize(e), out);
+    CHECK_EQ(serializez::serialize(envelope{}), R"({"route":"","body":null,"extra":null,"seq":0,"opt":null})");
+
+    // The body has an object among its tags, so parse_as() fails on it.
+    payload p{};
+    CHECK_EQ(e.body.parse_as(p), 1);
+    CHECK_EQ(e.body.parse_as<payload>().id, 0);
+    p = serializez::raw_json{R"({"id":7,"name":"x\"}","tags":[1,2]})"}.parse_as<payload>();
+    CHECK_EQ(p.id, 7);
+    CHECK_EQ(p.name, "x\"}");
+    CHECK_EQ(p.tags.size(), 2ul);
+    double d = 0.0;
+    CHECK_EQ(e.extra.parse_as(d), 0);
+    CHECK_EQ(d, 12500.0);
+
+    serializez::raw_json top;
+    CHECK_EQ(serializez::deserialize(top, std::string_view{"  [1, 2]  "}), 0);
+    CHECK_EQ(text_of(top), "[1, 2]");
+    CHECK_EQ(serializez::deserialize(e, std::string_view{R"({"body": [1,2)"}), 1);
+
+    // Brackets must match; anything else inside is forwarded unchecked.
+    envelope f{};
+    CHECK_EQ(serializez::deserialize(f, std::string_view{R"({"body":[1,,}, "seq":1})"}), 1);
+    CHECK_EQ(serializez::deserialize(f, std::string_view{R"({"body":{"a":[1}]}, "seq":1})"}), 1);
+    CHECK_EQ(serializez::deserialize(f, std::string_view{R"({"body":[{"a":"]}"}], "seq":1})"}), 0);
+    CHECK_EQ(text_of(f.body), R"([{"a":"]}"}])");
+    CHECK_EQ(serializez::deserialize(f, std::string_view{R"({"body":[1,,2], "seq":1})"}), 0);
+    CHECK_EQ(serializez::validate(text_of(f.body)).error, 1);
+    std::string deep = R"({"body":)" + std::string(serializez::default_max_depth, '[') +
+                       std::string(serializez::default_max_depth, ']') + "}";
+    CHECK_EQ(serializez::deserialize(f, std::string_view{deep}), 7);
+    deep = R"({"body":)" + std::string(serializez::default_max_depth - 1, '[') +
+           std::string(serializez::default_max_depth - 1, ']') + "}";
+    CHECK_EQ(serializez::deserialize(f, std::string_view{deep}), 0);
+
+    // Bound from a parsed Document, every kind of value is the same span.
+    serializez::Document doc;
+    CHECK_EQ(serializez::parse(in, doc), 0);
+    envelope bound{};
+    CHECK_EQ(serializez::deserialize(bound, doc.root()), 0);
+    CHECK(bound.body == e.body);
+    CHECK(bound.body.json().data() == e.body.json().data());
+    CHECK(bound.extra == e.extra);
+    CHECK(*bound.opt == *e.opt);
+    CHECK_EQ(serializez::serialize(bound), out);
+    for (std::string_view value : {"true", "false", "null", "-0.5", "17", R"("")", R"("é\n")", "[]", "{}",
+                                   R"([{"a":[]},"]"])", R"({"k":{"k":"}"}})"}) {
+        std::string json = R"({"value": )" + std::string(value) + " }";
+        wrapped w{};
+        CHECK_EQ(serializez::parse(json, doc), 0);
+        CHECK_EQ(serializez::deserialize(w, doc.root()), 0);
+        CHECK_EQ(text_of(w.value), value);
+    }
+
+    // A push_parser Document keeps no input to view.
+    serializez::Document pushed;
+    serializez::push_parser parser(pushed);
+    CHECK_EQ(parser.feed(in), 0);
+    CHECK_EQ(parser.finish(), 0);
+    CHECK_EQ(serializez::deserialize(bound, pushed.root()), 1);
+
+    return report();
+}
@@ -0,0 +1,57 @@
+#include <serialize.h>
+#include "check.h"
+#include <sstream>
+
+struct event { int id; std::string kind; };
+
+// Reads every record, skipping malformed ones like the README idiom, and
+// returns the ids read followed by the final error code.
+std::vector<int> read_all(const std::string& input, std::size_t buffer_size = 64) {
+    std::istringstream in(input);
+    serializez::record_reader<event> reader(in, buffer_size);
+    std::vector<int> ids;
+    event e{};
+    for (int calls = 0; calls < 100; ++calls) {
+        if (reader.next(e)) {
+            ids.push_back(e.id);
+        } else if (reader.error() != 1) {
+            ids.push_back(-reader.error());
+            return ids;
+        }
+    }
+    ids.push_back(-100);  // never reached the end
+    return ids;
+}
+
+int main() {
+    using ids = std::vector<int>;
+    CHECK(read_all(R"({"id":1,"kind":"a"})" "\n" R"({"id":2,"kind":"b"})" "\n") == ids({1, 2, 0}));
+    CHECK(read_all(R"({"id":1,"kind":"a"}{"id":2,"kind":"}{"})") == ids({1, 2, 0}));
+    CHECK(read_all(R"({"id":1,"kind":"a"} {"id":"x"} {"id":3,"kind":"c"})") == ids({1, 3, 0}));
+    CHECK(read_all("") == ids({0}));
+
+    // A record cut off by the end of the input is reported once.
+    CHECK(read_all(R"({"id":1,"kind":"a"})" "\n" R"({"id":2,"ki)") == ids({1, 0}));
+    std::istringstream truncated(R"({"id":1)");
+    serializez::record_reader<event> reader(truncated);
+    event e{};
+    CHECK(!reader.next(e));
+    CHECK_EQ(reader.error(), 1);
+    CHECK(!reader.next(e));
+    CHECK_EQ(reader.error(), 0);
+
+    // Scalar records may end at the end of the input.
+    std::istringstream numbers("1\n2");
+    serializez::record_reader<int> ints(numbers);
+    int value = 0;
+    CHECK(ints.next(value) && value == 1);
+    CHECK(ints.next(value) && value == 2);
+    CHECK(!ints.next(value));
+    CHECK_EQ(ints.error(), 0);
+    CHECK(!ints.next(value));
+    CHECK_EQ(ints.error(), 0);
+
+    // A record larger than the buffer is error 4.
+    CHECK(read_all(R"({"id":1,"kind":")" + std::string(100, 'x') + "\"}", 32) == ids({-4}));
+    return report();
+}
@@ -0,0 +1,37 @@
+#include <serialize.h>
+#include "check.h"
+#include <sstream>
+
+struct point { int x; bool on; std::array<short, 3> tags; };
+struct named { std::string name; };
+
+// Only ranges whose size is part of the type have a bound.
+static_assert(serializez::max_serialized_size<std::array<int, 4>>() == 4 * 11 + 5);
+static_assert(serializez::max_serialized_size<int[4]>() == 4 * 11 + 5);
+static_assert(serializez::max_serialized_size<std::span<const int, 4>>() == 4 * 11 + 5);
+static_assert(serializez::max_serialized_size<point>() != serializez::unbounded_size);
+static_assert(serializez::max_serialized_size<std::span<const int>>() == serializez::unbounded_size);
+static_assert(serializez::max_serialized_size<std::vector<int>>() == serializez::unbounded_size);
+static_assert(serializez::max_serialized_size<named>() == serializez::unbounded_size);
+// A subrange is tuple-like with two elements, not a range of two values.
+using int_subrange = std::ranges::subrange<std::vector<int>::const_iterator>;
+static_assert(serializez::max_serialized_size<int_subrange>() == serializez::unbounded_size);
+
+int main() {
+    std::vector<int> values(1000, -123456789);
+    std::string expected = serializez::serialize(values);
+    CHECK_EQ(serializez::serialize(std::ranges::subrange(values.cbegin(), values.cend())), expected);
+    std::ostringstream out;
+    CHECK_EQ(serializez::serialize_to(out, std::ranges::subrange(values.cbegin(), values.cend())), 0);
+    CHECK_EQ(out.str(), expected);
+
+    // Bounded types still serialize the same through the unchecked sinks.
+    point p{-2147483647 - 1, false, {-32768, 0, 32767}};
+    std::string json = serializez::serialize(p);
+    CHECK_EQ(json, R"({"x":-2147483648,"on":false,"tags":[-32768,0,32767]})");
+    CHECK(json.size() <= serializez::max_serialized_size<point>());
+    int fixed[4] = {1, 2, 3, 4};
+    CHECK_EQ(serializez::serialize(std::span<const int, 4>(fixed)), "[1,2,3,4]");
+
+    return report();
+}
@@ -0,0 +1,60 @@
+#include <serialize.h>
+#include "check.h"
+
+// validate() must agree with parse() on every input with well-formed UTF-8.
+bool agrees(std::string_view json) {
+    serializez::Document doc;
+    int parsed = serializez::parse(json, doc);
+    int validated = serializez::validate(json).error;
+    if (parsed != validated) {
+        std::fprintf(stderr, "  [%.*s] parse=%d validate=%d\n", static_cast<int>(json.size()), json.data(), parsed, validated);
+    }
+    return parsed == validated;
+}
+
+int main() {
+    std::string_view cases[] = {
+        R"({"a":1,"b":[true,false,null,-0.5e3,"xé😀"],"c":{}})", "[]", " 1 ", R"("")", "{}", "\t\n\r [] ",
+        R"({"a":1,})", "[1,2", R"("abc)", R"("a\qb")", R"("\ud800")", R"("\uDE00")", R"("😀")",
+        R"("\u0000")", R"("\u12")", R"("\/")", "01", "-01", "00", "1.", "2.", "-", "[-]", "[--1]", ".5", "+1",
+        "0x10", "1e", "1e+", "1.5.5", "1e5e5", "[1e]", "-0", "0.0e+0", "1E5", "1e999", "-1e999", "1e-999",
+        "123456789012345678901234567890", "-9223372036854775809", "9223372036854775807", R"({"a" 1})", "[1] 2",
+        R"({"a":1])", "[nul]", "nul", "tru", "truex", "[true false]", "[1 2]", R"({"a":1 "b":2})", "[1,]",
+        R"(["a",])", "{,}", R"({"a":1,"a":2})", R"({1:2})", "[,1]", "[:]", R"({"a"})", R"({"a":})", "[[]", "[]]",
+        "{}}", "", "   ", "\x0b[]", std::string_view{"[1]\0", 4}, "\"a\tb\"", "\"a\x1f\"", "\"x\x7f\"",
+    };
+    for (std::string_view json : cases) { CHECK(agrees(json)); }
+
+    // Every prefix of a valid document, and every one-byte change of it to
+    // a structural character, is judged the same way.
+    std::string doc = R"({"k":[1,-2.5e-3,true,null,{"s":"a\"b\\u00e9"},[]],"x":{"y":false}})";
+    for (std::size_t i = 0; i <= doc.size(); ++i) { CHECK(agrees(std::string_view{doc}.substr(0, i))); }
+    for (std::size_t i = 0; i < doc.size(); ++i) {
+        for (char c : {'{', '}', '[', ']', ',', ':', '"', '\\', ' ', '1', '-', '.', 'e', 'x', '\n'}) {
+            std::string changed = doc;
+            changed[i] = c;
+            CHECK(agrees(changed));
+        }
+    }
+
+    // Nesting is limited to default_max_depth like parse().
+    std::string deepest = std::string(serializez::default_max_depth, '[') + std::string(serializez::default_max_depth, ']');
+    CHECK(agrees(deepest));
+    CHECK(agrees("[" + deepest + "]"));
+    CHECK_EQ(serializez::validate("[" + deepest + "]").error, 7);
+
+    // Ill-formed UTF-8 is rejected by validate() only.
+    for (std::string_view bad : {"\"\xc3\"", "\"\xe0\x80\x80\"", "\"\xed\xa0\x80\"", "\"\xf4\x90\x80\x80\"", "\"\xff\""}) {
+        CHECK_EQ(serializez::validate(bad).error, 1);
+        CHECK_EQ(serializez::validate(bad).offset, 1ul);
+    }
+    CHECK_EQ(serializez::validate("\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80 and a long ASCII run past the vector width\"").error, 0);
+
+    // The offset is where the error was found.
+    CHECK_EQ(serializez::validate(R"({"a":1,})").offset, 7ul);
+    CHECK_EQ(serializez::validate("[1] 2").offset, 4ul);
+    CHECK_EQ(serializez::validate("[1, 1e999]").offset, 4ul);
+    CHECK_EQ(serializez::validate(R"(["a\qb"])").offset, 3ul);
+
+    return report();
+}